@@ -0,0 +1,375 @@
+//
+// ofxWinMenu benchmark
+//
+// Times the item model with the menus kept in memory by ofxWinMenuRecorder,
+// so the results show the time taken by ofxWinMenu and not by Windows.
+// Each operation is timed for menus of 10, 100, 1000, 10000 and 100000 items.
+// CreateMenuFromText is timed for a description of 5000 items.
+// Selection is also timed for a menu created from a definition of 7 items
+// with an ofApp function that switches on ofxWinMenuID.
+// Command IDs are 16 bit, so the largest menu has fewer items than its size
+// and the number of items is in the results.
+//
+//     ofxWinMenuBench [--json] [--max size]
+//
+// One line is written for each operation and size, as CSV or as JSON :
+//
+//     operation,size,items,ops,total_ms,ns_per_op
+//
+// The files are written to the working directory.
+//
+#include "ofxWinMenu.h"
+#include "ofxWinMenuRecorder.h"
+#include "headless.h"
+#include <cstring>
+
+// Menu with item numbers known at compile time
+static constexpr ofxWinMenuDef switchMenu[] = {
+	{ OFXMENU_POPUP, "File" },
+		{ OFXMENU_ITEM, "Open", false, false },
+		{ OFXMENU_ITEM, "Save", false, false },
+		{ OFXMENU_SEPARATOR },
+		{ OFXMENU_ITEM, "Exit", false, false },
+	{ OFXMENU_END },
+	{ OFXMENU_POPUP, "View" },
+		{ OFXMENU_ITEM, "Show info", true },
+		{ OFXMENU_ITEM, "Full screen" },
+		{ OFXMENU_ITEM, "Grid" },
+		{ OFXMENU_ITEM, "Axes" },
+	{ OFXMENU_END },
+};
+static const int switchItems[] = {
+	OFXWINMENU_ID(switchMenu, "Open"), OFXWINMENU_ID(switchMenu, "Save"), OFXWINMENU_ID(switchMenu, "Exit"),
+	OFXWINMENU_ID(switchMenu, "Show info"), OFXWINMENU_ID(switchMenu, "Full screen"),
+	OFXWINMENU_ID(switchMenu, "Grid"), OFXWINMENU_ID(switchMenu, "Axes") };
+static const int nSwitchItems = 7;
+
+class ofApp {
+	public:
+		void appMenuCommand(int, bool) {
+			nCommands++;
+		}
+		void appMenuSwitch(int item, bool bChecked) {
+			switch(item) {
+				case ofxWinMenuID(switchMenu, "Open") : nCommands++; break;
+				case ofxWinMenuID(switchMenu, "Save") : nCommands += 2; break;
+				case ofxWinMenuID(switchMenu, "Exit") : nCommands += 3; break;
+				case ofxWinMenuID(switchMenu, "Show info") : bShowInfo = bChecked; break;
+				case ofxWinMenuID(switchMenu, "Full screen") : bFullScreen = bChecked; break;
+				case ofxWinMenuID(switchMenu, "Grid") : bGrid = bChecked; break;
+				case ofxWinMenuID(switchMenu, "Axes") : bAxes = bChecked; break;
+			}
+		}
+		int nCommands = 0;
+		bool bShowInfo = false;
+		bool bFullScreen = false;
+		bool bGrid = false;
+		bool bAxes = false;
+};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+struct result {
+	const char *operation;
+	int size;
+	int items;
+	long long ops;
+	double ms;
+};
+
+static std::vector<result> results;
+
+// Time of a function in milliseconds
+template<typename F>
+static double Time(F function)
+{
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Report(const char *operation, int size, int items, long long ops, double ms)
+{
+	results.push_back({ operation, size, items, ops, ms });
+}
+
+// Menu with popup menus of up to 1000 items each
+struct benchMenu {
+	ofxWinMenu *menu = nullptr;
+	std::vector<HMENU> popups;
+	std::vector<int> items;
+	std::vector<std::string> names;
+};
+
+static void DeleteMenu(benchMenu &m)
+{
+	if(!m.menu)
+		return;
+	m.menu->RemoveWindowMenu();
+	m.menu->DestroyWindowMenu();
+	delete m.menu;
+	m.menu = nullptr;
+}
+
+static double CreateMenu(benchMenu &m, ofApp &app, ofxWinMenuRecorder &recorder, HWND hwnd, int nItems)
+{
+	m.menu = new ofxWinMenu(&app, hwnd, &recorder);
+	m.menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hMenu = m.menu->CreateWindowMenu();
+	m.popups.clear();
+	for(int p = 0; p < (nItems + 999) / 1000; p++)
+		m.popups.push_back(m.menu->AddPopupMenu(hMenu, "Popup " + std::to_string(p)));
+	m.menu->SetWindowMenu();
+	m.items.assign(nItems, -1);
+	return Time([&]() {
+		for(int i = 0; i < nItems; i++)
+			m.items[i] = m.menu->AddPopupItemID(m.popups[i / 1000], m.names[i], i % 3 == 0);
+	});
+}
+
+// Number of repetitions for at least a number of operations
+static int Reps(long long minOps, long long ops)
+{
+	return (int)std::max(1LL, minOps / std::max(1LL, ops));
+}
+
+static void Bench(int size, ofxWinMenuRecorder &recorder, HWND hwnd, HWND hwndSwitch)
+{
+	// Items and separators within the 16 bit command IDs
+	const int nItems = std::min(size, 60000);
+	const int nSeparators = std::max(1, nItems / 20);
+	ofApp app;
+	benchMenu m;
+	m.names.reserve(nItems);
+	for(int i = 0; i < nItems; i++)
+		m.names.push_back("Item " + std::to_string(i));
+
+	// AddPopupItem to new menus
+	int reps = Reps(100000, nItems);
+	double ms = 0.0;
+	for(int r = 0; r < reps; r++) {
+		if(r > 0)
+			DeleteMenu(m);
+		ms += CreateMenu(m, app, recorder, hwnd, nItems);
+	}
+	Report("add", size, nItems, (long long)reps * nItems, ms);
+
+	// AddPopupSeparator after the items
+	ms = Time([&]() {
+		for(int i = 0; i < nSeparators; i++)
+			m.menu->AddPopupSeparator(m.popups[i % m.popups.size()]);
+	});
+	Report("separator", size, nItems, nSeparators, ms);
+
+	// Item states by number and by name
+	const long long minOps = 1000000;
+	reps = Reps(minOps, nItems);
+	long long ops = (long long)reps * nItems;
+	Report("set_id", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				m.menu->SetPopupItem(m.items[i], (i + r) % 2 == 0);
+	}));
+	Report("set_name", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				m.menu->SetPopupItem(m.names[i], (i + r) % 2 == 1);
+	}));
+	int nChecked = 0;
+	Report("get_id", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				nChecked += m.menu->GetPopupItem(m.items[i]);
+	}));
+	Report("get_name", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				nChecked += m.menu->GetPopupItem(m.names[i]);
+	}));
+	Report("enable_id", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				m.menu->EnablePopupItem(m.items[i], (i + r) % 2 == 1);
+	}));
+	for(int i = 0; i < nItems; i++)
+		m.menu->EnablePopupItem(m.items[i], true);
+
+	// Name found by the index, and by comparing each name as before the index
+	Report("find_index", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				nChecked += m.menu->FindItem(m.names[i]) >= 0;
+	}));
+	long long scanOps = std::min(nItems, 2000);
+	Report("find_scan", size, nItems, scanOps, Time([&]() {
+		for(long long n = 0; n < scanOps; n++) {
+			const std::string &name = m.names[(n * 7919) % nItems];
+			for(size_t i = 0; i < m.menu->itemNames.size(); i++) {
+				if(m.menu->itemNames[i] == name) {
+					nChecked++;
+					break;
+				}
+			}
+		}
+	}));
+
+	// Selection by WM_COMMAND, with auto check and the ofApp function
+	Report("dispatch", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				SendMessageA(hwnd, WM_COMMAND, m.items[i], 0);
+	}));
+
+	// The same number of selections of a menu created from a definition,
+	// with an ofApp function that switches on ofxWinMenuID case labels
+	ofxWinMenu *switchMenuObject = new ofxWinMenu(&app, hwndSwitch, &recorder);
+	switchMenuObject->CreateMenuFunction(&ofApp::appMenuSwitch);
+	switchMenuObject->CreateMenuFromDef(switchMenu);
+	switchMenuObject->SetWindowMenu();
+	Report("dispatch_switch", size, nSwitchItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			for(int i = 0; i < nItems; i++)
+				SendMessageA(hwndSwitch, WM_COMMAND, switchItems[i % nSwitchItems], 0);
+	}));
+	switchMenuObject->RemoveWindowMenu();
+	switchMenuObject->DestroyWindowMenu();
+	delete switchMenuObject;
+
+	// Save of the initialization file only, and with the binary state file
+	std::string inipath = "./ofxWinMenuBench.ini";
+	std::string binpath = m.menu->GetBinaryPath(inipath);
+	DeleteFileA(inipath.c_str());
+	DeleteFileA(binpath.c_str());
+	reps = Reps(20000, nItems);
+	ops = (long long)reps * nItems;
+	Report("save", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			m.menu->Save(inipath, true);
+	}));
+
+	// Load with every other item changed
+	auto Invert = [&]() {
+		m.menu->BeginUpdate();
+		for(int i = 0; i < nItems; i += 2)
+			m.menu->SetPopupItem(m.items[i], !m.menu->GetPopupItem(m.items[i]));
+		m.menu->EndUpdate();
+	};
+	ms = 0.0;
+	for(int r = 0; r < reps; r++) {
+		Invert();
+		ms += Time([&]() { m.menu->Load(inipath); });
+	}
+	Report("load", size, nItems, ops, ms);
+
+	m.menu->SetBinaryState(true);
+	Report("save_binary", size, nItems, ops, Time([&]() {
+		for(int r = 0; r < reps; r++)
+			m.menu->Save(inipath, true);
+	}));
+	ms = 0.0;
+	for(int r = 0; r < reps; r++) {
+		Invert();
+		ms += Time([&]() { m.menu->Load(inipath); });
+	}
+	Report("load_binary", size, nItems, ops, ms);
+	m.menu->SetBinaryState(false);
+	DeleteFileA(binpath.c_str());
+
+	// Each key written by reading, changing and writing the whole file,
+	// the same as WritePrivateProfileString for each item before
+	long long keyOps = std::min(nItems, 200);
+	Report("save_per_key", size, nItems, keyOps, Time([&]() {
+		for(long long n = 0; n < keyOps; n++) {
+			std::string text;
+			{
+				std::ifstream infile(inipath, std::ios::binary);
+				text.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+			}
+			int i = (int)((n * 7919) % nItems);
+			text = ofxWinMenu::MergeIniSection(text, "Menu", { { m.names[i], m.menu->GetPopupItem(m.items[i]) ? "1" : "0" } });
+			std::ofstream outfile(inipath, std::ios::binary | std::ios::trunc);
+			outfile << text;
+		}
+	}));
+	DeleteFileA(inipath.c_str());
+
+	if(nChecked < 0)
+		printf("%d\n", nChecked); // Results are used
+	DeleteMenu(m);
+}
+
+// CreateMenuFromText for a generated description of popup menus of 100 items,
+// with every option and a separator after every tenth item
+static void BenchText(int nItems, ofxWinMenuRecorder &recorder, HWND hwnd)
+{
+	static const char *options[] = { "", " | checked", " | noauto", " | disabled", " | checked noauto" };
+	std::string text;
+	for(int i = 0; i < nItems; i++) {
+		if(i % 100 == 0)
+			text += "Popup " + std::to_string(i / 100) + " {\n";
+		text += "\tItem " + std::to_string(i) + options[i % 5] + "\n";
+		if(i % 10 == 9)
+			text += "\t-\n";
+		if(i % 100 == 99 || i == nItems - 1)
+			text += "}\n";
+	}
+
+	int reps = Reps(50000, nItems);
+	double ms = 0.0;
+	bool bCreated = true;
+	for(int r = 0; r < reps; r++) {
+		ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+		ms += Time([&]() { bCreated = menu->CreateMenuFromText(text) && bCreated; });
+		menu->DestroyWindowMenu();
+		delete menu;
+	}
+	if(!bCreated)
+		fprintf(stderr, "CreateMenuFromText failed\n");
+	Report("text", nItems, nItems, (long long)reps * nItems, ms);
+}
+
+int main(int argc, char *argv[])
+{
+	bool bJson = false;
+	int maxSize = 100000;
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--json") == 0)
+			bJson = true;
+		else if(strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+			maxSize = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "ofxWinMenuBench [--json] [--max size]\n");
+			return 1;
+		}
+	}
+
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	HWND hwndSwitch = HeadlessCreateWindow(AppWndProc);
+	for(int size : { 10, 100, 1000, 10000, 100000 }) {
+		if(size <= maxSize)
+			Bench(size, recorder, hwnd, hwndSwitch);
+	}
+	BenchText(5000, recorder, hwnd);
+	HeadlessDestroyWindow(hwndSwitch);
+	HeadlessDestroyWindow(hwnd);
+
+	if(bJson) {
+		printf("{\"benchmark\":\"ofxWinMenu\",\"results\":[");
+		for(size_t i = 0; i < results.size(); i++) {
+			const result &r = results[i];
+			printf("%s\n{\"operation\":\"%s\",\"size\":%d,\"items\":%d,\"ops\":%lld,\"total_ms\":%.3f,\"ns_per_op\":%.1f}",
+				i > 0 ? "," : "", r.operation, r.size, r.items, r.ops, r.ms, r.ms * 1e6 / (double)r.ops);
+		}
+		printf("\n]}\n");
+	}
+	else {
+		printf("operation,size,items,ops,total_ms,ns_per_op\n");
+		for(const result &r : results)
+			printf("%s,%d,%d,%lld,%.3f,%.1f\n", r.operation, r.size, r.items, r.ops, r.ms, r.ms * 1e6 / (double)r.ops);
+	}
+	return 0;
+}
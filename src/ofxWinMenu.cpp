@@ -39,31 +39,243 @@
 	10.01.25 - Change Load from void to bool
 	17.01.25 - Constructor - change LongPtrA functions to LongPtr
 	18.01.25 - Constructor - conditional Unicode for menu name
+	16.10.26 - Add item name index to find items without a search
+			 - SetPopupItem uses the item position directly
+			 - Separate the item table from the Windows menu functions
+			 - Separators have their own item number as command ID
+			 - Add AddPopupItemID and item number functions
+			 - Add SetItemFunction for a function for each item
+			 - Add CreateMenuFunction for a string_view title
+			 - MenuFunction title by reference
+			 - Add BeginUpdate and EndUpdate
+			 - Add PostSetPopupItem and PostEnablePopupItem for other threads
+			 - Item checked and enabled flags can be read by any thread
+			 - Add Snapshot
+			 - Save writes the file once, replacing it when complete
+			 - Load reads the file once and changes the menu in one update
+			 - Add SetBinaryState for a binary copy of the item states
+			 - Add SetAutoSave to save changed items after a quiet period
+			 - Add SaveAsync to write the file with a separate thread
+			 - Add CreateMenuFromText and CreateMenuFromFile
+			 - Add CreateMenuFromDef and item number menu function
+			 - Add AddLazyPopupMenu for popup menus filled when opened
+			 - Add MenuCommand for selection of a menu item
+			 - Item positions are kept in a tree for each submenu
+			 - Add InsertPopupItemAt, RemovePopupItem and GetItemPosition
+			 - Popup menus of any depth are recorded with their parent menu
+			 - AddPopupSeparator adds at the end without counting menu items
+			 - Add InsertPopupMenuAt, GetParentMenu and GetPopupCount
+			 - Menu object found from the window for more than one window
+			 - Window message procedure saved for each menu object
+			 - Add radio groups with AddRadioGroup and AddRadioItem
+			 - Add SetItemAccelerator for keyboard shortcuts of menu items
+			 - Add context menus sharing items with the window menu
+			 - MenuEnableItem uses the submenu of the item
+			 - Add command metrics with OFXWINMENU_METRICS defined
+			 - Add StartTrace and SaveTrace to record a trace of menu activity
+			 - Menus changed through a backend given to the constructor
+			 - Items of the same name remain found when one is removed
+			 - Binary state file older than the initialization file is not loaded
+			 - Binary state file restores checked states only, the same as Load
+			 - Auto save deletes the binary state file it makes out of date
+			 - SaveAsync does not replace a file with states older than it has
+			 - CreateMenuFromText options are whole words and unknown words are errors
+			 - Command IDs for lazy popup menus are reserved only when they are added
+			 - Window subclassed with SetWindowSubclass so other procedures stay in the chain
+			 - Command metrics members are the same with or without OFXWINMENU_METRICS
+			 - Trace time origin read without a data race
+			 - DestroyWindowMenu removes the items of the menu it destroys
+			 - Load finds the selected radio item within its own group
+			 - SaveAsync writes are waited for when the menu is deleted
+			 - EndUpdate keeps the changes if the menu is not valid
+			 - WM_CLOSE ends the application for the main window only
+			 - SetBinaryState can save the binary file instead of the initialization file
+			 - Radio groups are ofxWinMenuGroup so they cannot be used as item numbers
 
 
 */
 #include "ofxWinMenu.h"
+#include <CommCtrl.h> // For window subclassing
+#ifdef _MSC_VER
+#pragma comment(lib, "Comctl32.lib")
+#endif
+
+// Local window message procedure, with the ofxWinMenu class pointer as reference data
+static LRESULT CALLBACK ofxWinMenuWndProc(HWND, UINT, WPARAM, LPARAM, UINT_PTR, DWORD_PTR);
+static const UINT_PTR menuSubclassID = 1; // Subclass of the window for the menu
+static std::atomic<HWND> mainWindow(NULL); // First window with a menu object, closing it quits
+static UINT postedMessage = RegisterWindowMessageA("ofxWinMenuPosted"); // Posted item changes
+
+// Menu loop titles returned to ofApp
+static const std::string menuLoopEnter = "WM_ENTERMENULOOP";
+static const std::string menuLoopExit = "WM_EXITMENULOOP";
+
+// Compare initialization file names, which are not case sensitive
+static bool IniNameEqual(const std::string &a, const std::string &b)
+{
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+			return false;
+	}
+	return true;
+}
+
+// Lower case name for comparison
+static std::string IniLower(const std::string &name)
+{
+	std::string lower = name;
+	for (char &c : lower) c = (char)tolower((unsigned char)c);
+	return lower;
+}
+
+// Remove spaces, tabs and line ends from both ends
+static std::string IniTrim(const std::string &str)
+{
+	size_t first = str.find_first_not_of(" \t\r");
+	if (first == std::string::npos) return "";
+	size_t last = str.find_last_not_of(" \t\r");
+	return str.substr(first, last - first + 1);
+}
+
+// A file was last written before another file
+static bool IsFileOlder(const std::string &path, const std::string &other)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data{}, otherData{};
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)
+		|| !GetFileAttributesExA(other.c_str(), GetFileExInfoStandard, &otherData))
+		return false;
+	return CompareFileTime(&data.ftLastWriteTime, &otherData.ftLastWriteTime) < 0;
+}
+
+#ifdef _WIN32
+
+//
+// Windows menu backend
+//
+class ofxWinMenuWindows : public ofxWinMenuBackend {
+
+	public:
+
+		HMENU CreateMenuBar() { return CreateMenu(); }
+		HMENU CreatePopup() { return CreatePopupMenu(); }
+		bool DestroyMenuHandle(HMENU hMenu) { return (bool)DestroyMenu(hMenu); }
+		bool IsMenuHandle(HMENU hMenu) { return (bool)IsMenu(hMenu); }
+		HMENU GetWindowMenu(HWND hwnd) { return GetMenu(hwnd); }
+		bool SetWindowMenu(HWND hwnd, HMENU hMenu) { return (bool)SetMenu(hwnd, hMenu); }
+		bool RedrawMenuBar(HWND hwnd) { return (bool)DrawMenuBar(hwnd); }
+		int GetItemCount(HMENU hMenu) { return GetMenuItemCount(hMenu); }
+
+		bool InsertItem(HMENU hMenu, UINT position, UINT flags, UINT_PTR id, const char *text) {
+			return (bool)InsertMenuA(hMenu, position, flags, id, text);
+		}
+
+		bool AppendItem(HMENU hMenu, UINT flags, UINT_PTR id, const char *text) {
+			return (bool)AppendMenuA(hMenu, flags, id, text);
+		}
+
+		bool DeleteItem(HMENU hMenu, UINT position, UINT flags) {
+			return (bool)DeleteMenu(hMenu, position, flags);
+		}
+
+		bool CheckItem(HMENU hMenu, UINT item, UINT flags) {
+			return CheckMenuItem(hMenu, item, flags) != (DWORD)-1;
+		}
+
+		bool EnableItem(HMENU hMenu, UINT item, UINT flags) {
+			return EnableMenuItem(hMenu, item, flags) != -1;
+		}
+
+		bool SetItemText(HMENU hMenu, UINT item, UINT flags, const char *text) {
+			MENUITEMINFOA info{};
+			info.cbSize = sizeof(MENUITEMINFOA);
+			info.fMask = MIIM_STRING;
+			info.dwTypeData = (LPSTR)text;
+			return (bool)SetMenuItemInfoA(hMenu, item, (flags & MF_BYPOSITION) != 0, &info);
+		}
+
+		bool SetItemRadio(HMENU hMenu, UINT item, UINT flags) {
+			MENUITEMINFOA info{};
+			info.cbSize = sizeof(MENUITEMINFOA);
+			info.fMask = MIIM_FTYPE;
+			info.fType = MFT_STRING | MFT_RADIOCHECK;
+			return (bool)SetMenuItemInfoA(hMenu, item, (flags & MF_BYPOSITION) != 0, &info);
+		}
+
+		bool TrackPopup(HMENU hMenu, HWND hwnd) {
+			POINT pt{};
+			if(!GetCursorPos(&pt))
+				return false;
+			// The menu closes if the user clicks outside it
+			SetForegroundWindow(hwnd);
+			return (bool)TrackPopupMenu(hMenu, TPM_LEFTALIGN | TPM_TOPALIGN | TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwnd, NULL);
+		}
+
+};
+
+ofxWinMenuBackend *ofxWinMenuBackend::Default()
+{
+	static ofxWinMenuWindows windowsBackend;
+	return &windowsBackend;
+}
+
+#endif
 
-static LRESULT CALLBACK ofxWinMenuWndProc(HWND, UINT, WPARAM, LPARAM); // Local window message procedure
-static WNDPROC ofAppWndProc; // Openframeworks application window message procedure
-static ofxWinMenu *pThis; // Pointer to access the ofxWinMenu class from the window procedure
+ofxWinMenu::ofxWinMenu(ofApp *app, HWND hwnd, ofxWinMenuBackend *menuBackend) {
 
-ofxWinMenu::ofxWinMenu(ofApp *app, HWND hwnd) {
+	// Windows menu functions unless another backend is given
+	backend = menuBackend ? menuBackend : ofxWinMenuBackend::Default();
 
 	g_hMenu = NULL; // Set by CreateMenu and returned to ofApp
 	pAppMenuFunction = NULL; // Set by CreateMenuFunction to return menu state to ofApp
+	pAppMenuViewFunction = NULL;
+	pAppItemFunction = NULL;
+
+	nUpdates = 0; // No update in progress
+	nUpdateCalls = 0;
+	nUpdateSaved = 0;
+
+	postedChanges = nullptr; // No posted item changes
+	flagSequence = 0; // No item flag changes
+	bBinaryState = false; // Initialization file only
+	bBinaryOnly = false;
+	trace = std::make_shared<ofxWinMenuTrace>(); // Not recording
+	traceLoopStart = -1;
+	orderRandom = 2463534242u; // Submenu order node priorities
+	lazyFirstID = maxCommandID; // No lazy popup menus
+
+	bAutoSave = false; // No auto save
+	bAutoSaveQuit = false;
+	bAutoSavePending = false;
+	nAutoSaveWrites = 0;
+	nAutoSaveChanges = 0;
 
 	// The window handle of ofApp
 	g_hwnd = hwnd;
 
-	pThis = this; // Pointer for access the ofxWinMenu class
 	pApp = app; // The ofApp class pointer
+	bSubclassed = false;
+
+	// The first window with a menu object is the main window of ofApp,
+	// and closing it ends the application. Other windows close normally.
+	HWND hMain = mainWindow.load();
+	if (!hMain || !IsWindow(hMain)) {
+		mainWindow.compare_exchange_strong(hMain, g_hwnd);
+		hMain = mainWindow.load();
+	}
+	bQuitOnClose = (hMain == g_hwnd);
 
-	// Save the Openframeworks application window message procedure
-	ofAppWndProc = (WNDPROC)GetWindowLongPtr(g_hwnd, GWLP_WNDPROC);
+	// Each window can have one menu object
+	DWORD_PTR refData = 0;
+	if (GetWindowSubclass(g_hwnd, ofxWinMenuWndProc, menuSubclassID, &refData)) {
+		printf("ofxWinMenu\nThe window already has a menu\n");
+		return;
+	}
 
-	// Set our own window message procedure
-	SetWindowLongPtr(g_hwnd, GWLP_WNDPROC, (LONG_PTR)ofxWinMenuWndProc);
+	// Subclass the window with our own window message procedure.
+	// The class pointer is passed to it for this window, and messages
+	// not handled are passed on to the Openframeworks application.
+	bSubclassed = (SetWindowSubclass(g_hwnd, ofxWinMenuWndProc, menuSubclassID, (DWORD_PTR)this) != FALSE);
 
 	// Set the Menu name
 	#ifdef UNICODE
@@ -76,11 +288,57 @@ ofxWinMenu::ofxWinMenu(ofApp *app, HWND hwnd) {
 
 ofxWinMenu::~ofxWinMenu()
 {
+	// Save changes not yet saved
+	StopAutoSave();
+
+	// Wait for SaveAsync to finish writing
+	for (std::future<void> &write : saveWrites)
+		write.wait();
+	saveWrites.clear();
+
+	// Remove our window message procedure if the window still exists.
+	// Procedures set since remain in the chain.
+	if (bSubclassed && IsWindow(g_hwnd))
+		RemoveWindowSubclass(g_hwnd, ofxWinMenuWndProc, menuSubclassID);
+	bSubclassed = false;
+
+	// Context menus are not attached to the window
+	for (HMENU hContextMenu : contextMenus) {
+		if (backend->IsMenuHandle(hContextMenu))
+			backend->DestroyMenuHandle(hContextMenu);
+	}
+
+	// Delete changes posted but not made
+	postedChange *change = postedChanges.exchange(nullptr);
+	while(change) {
+		postedChange *next = change->next;
+		delete change;
+		change = next;
+	}
+
 	// Clear all vectors
+	itemIndex.clear();
 	subMenus.clear();
-	itemIDs.clear();
+	itemNodes.clear();
 	autoCheck.clear();
 	isChecked.clear();
+	isEnabled.clear();
+	itemFunctions.clear();
+	menuChecked.clear();
+	menuEnabled.clear();
+	isPending.clear();
+	updateItems.clear();
+	freeItems.clear();
+	itemGroups.clear();
+	radioGroups.clear();
+	itemKeys.clear();
+	keyIndex.clear();
+	itemMirrors.clear();
+	contextMenus.clear();
+	orderNodes.clear();
+	freeNodes.clear();
+	orderRoots.clear();
+	popupMenus.clear();
 
 }
 
@@ -91,26 +349,60 @@ ofxWinMenu::~ofxWinMenu()
 // Main menu we will create
 HMENU ofxWinMenu::CreateWindowMenu()
 {
-	HMENU hMenu = GetMenu(g_hwnd);
+	HMENU hMenu = backend->GetWindowMenu(g_hwnd);
 	if(!hMenu) 
-		g_hMenu = CreateMenu();
+		g_hMenu = backend->CreateMenuBar();
 	return g_hMenu;
 }
 
-// Popup menu of the main menu
+// Popup menu of the main menu or of another popup menu
 HMENU ofxWinMenu::AddPopupMenu(HMENU hMenu, std::string MenuName)
+{
+	return InsertPopupMenuAt(hMenu, -1, MenuName);
+}
+
+//
+// Insert a popup menu at a position
+//
+// The popup menu is inserted before the entry at the position in the menu,
+// or at the end if the position is -1. Popup menus can contain other
+// popup menus to any depth.
+//
+HMENU ofxWinMenu::InsertPopupMenuAt(HMENU hMenu, int position, std::string MenuName)
 {
 	if(hMenu) {
-		HMENU hSubMenu = CreatePopupMenu();
+		HMENU hSubMenu = backend->CreatePopup();
 		if(hSubMenu) {
-			AppendMenuA(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, MenuName.c_str());
-			return hSubMenu;
+			// The popup menu is an entry of the menu containing it
+			int node = NewOrderNode(hMenu, -1);
+			OrderInsert(node, position);
+			if(backend->InsertItem(hMenu, OrderPosition(node), MF_BYPOSITION | MF_POPUP, (UINT_PTR)hSubMenu, MenuName.c_str())) {
+				popupMenus[hSubMenu] = { hMenu, node };
+				return hSubMenu;
+			}
+			OrderRemove(node);
+			backend->DestroyMenuHandle(hSubMenu);
 		}
 	}
 	return NULL;
 
 }
 
+// The menu containing a popup menu, NULL if not a popup menu
+HMENU ofxWinMenu::GetParentMenu(HMENU hPopup)
+{
+	auto it = popupMenus.find(hPopup);
+	if(it == popupMenus.end())
+		return NULL;
+	return it->second.hParent;
+}
+
+// Number of items, separators and popup menus in a menu
+int ofxWinMenu::GetPopupCount(HMENU hMenu)
+{
+	return OrderCount(hMenu);
+}
+
 //
 // Popup menu items
 //
@@ -131,303 +423,2864 @@ bool ofxWinMenu::AddPopupItem(HMENU hSubMenu, std::string ItemName, bool bChecke
 
 bool ofxWinMenu::AddPopupItem(HMENU hSubMenu, std::string ItemName, bool bChecked, bool bAutoCheck)
 {
-	if(g_hMenu && hSubMenu) {
-		int nItem = GetMenuItemCount(hSubMenu);
-		int itemID = (int)itemIDs.size();
-		itemIDs.push_back(nItem);
-		subMenus.push_back(hSubMenu);
-		itemNames.push_back(ItemName);
-		isChecked.push_back(bChecked);
-		autoCheck.push_back(bAutoCheck);
-		if(InsertMenuA(hSubMenu, nItem, MF_BYPOSITION, itemID, ItemName.c_str())) {
-			if(bAutoCheck && bChecked) 
-				CheckMenuItem(hSubMenu, nItem, MF_BYPOSITION | MF_CHECKED);
-			return true;
-		}
-	}
-	return false;
+	return (AddPopupItemID(hSubMenu, ItemName, bChecked, bAutoCheck) >= 0);
 }
 
-// Item separator
-bool ofxWinMenu::AddPopupSeparator(HMENU hSubMenu)
+//
+// Popup menu item returning the item number
+//
+// The item number is the command ID of the menu item and does not change.
+// It can be used instead of the item name for SetPopupItem, EnablePopupItem
+// and GetPopupItem to avoid finding the item by name.
+//
+int ofxWinMenu::AddPopupItemID(HMENU hSubMenu, std::string ItemName, bool bChecked, bool bAutoCheck)
 {
-	int nItems = 0;
-	HMENU hSubSubMenu = NULL;
+	return InsertPopupItemAt(hSubMenu, -1, ItemName, bChecked, bAutoCheck);
+}
 
+//
+// Insert a popup menu item at a position
+//
+// The item is inserted before the entry at the position in the popup menu,
+// counting items, separators and popup menus, or at the end if the position
+// is -1. The item numbers of other items do not change.
+//
+int ofxWinMenu::InsertPopupItemAt(HMENU hSubMenu, int position, std::string ItemName, bool bChecked, bool bAutoCheck)
+{
 	if(g_hMenu && hSubMenu) {
-
-		int n = GetMenuItemCount(hSubMenu);
-
-		// Include popup submenus - allow for one level deep
-		for(int i = 0; i < n; i++) {
-			nItems++;
-			// Is the item a submenu of the popup menu ?
-			hSubSubMenu = GetSubMenu(hSubMenu, i);
-			if(hSubSubMenu) {
-				nItems++; // Include the submenu itself
-				// Add it's items to the incrementing count as we build the menu
-				nItems += GetMenuItemCount(hSubMenu); 
-			}
+		int item = AddItem(hSubMenu, position, ItemName, bChecked, bAutoCheck);
+		if(MenuInsertItem(item)) {
+			if(bAutoCheck && bChecked)
+				MenuCheckItem(item);
+			return item;
 		}
-		itemIDs.push_back(nItems);
-		subMenus.push_back(hSubMenu);
-		itemNames.push_back("");
-		isChecked.push_back(false);
-		autoCheck.push_back(false);
-
-		//
-		// The position indicates the menu item before which the new menu item is to be inserted
-		// as determined by the uFlags parameter (MF_BYPOSITION).
-		//
-		return (bool)InsertMenuA(hSubMenu, nItems, MF_BYPOSITION | MF_SEPARATOR, 0, NULL);
+		if(item >= 0)
+			RemoveItem(item);
 	}
-	return false;
+	return -1;
 }
 
-// Set the menu to the application
-bool ofxWinMenu::SetWindowMenu()
+//
+// Remove a popup menu item or separator
+//
+// The entries that follow move up in the popup menu. The item number
+// of the removed item can be used again by the next item added.
+//
+bool ofxWinMenu::RemovePopupItem(int item)
 {
-	if(g_hwnd && g_hMenu)
-		return (bool)SetMenu(g_hwnd, g_hMenu);
-	else
+	if(!IsItem(item) || !MenuRemoveItem(item))
 		return false;
+	RemoveItem(item);
+	return true;
 }
 
-// Remove the menu from the application
-bool ofxWinMenu::RemoveWindowMenu()
+bool ofxWinMenu::RemovePopupItem(std::string ItemName)
 {
-	if(g_hwnd)
-		return (bool)SetMenu(g_hwnd, NULL);
-	else
-		return false;
+	return RemovePopupItem(FindItem(ItemName));
 }
 
-// Destroy the menu - not normally used
-bool ofxWinMenu::DestroyWindowMenu()
+// Position of an item in its popup menu
+int ofxWinMenu::GetItemPosition(int item)
 {
-	if(g_hMenu)
-		return (bool)DestroyMenu(g_hMenu);
-	else
-		return false;
+	if(!IsItem(item))
+		return -1;
+	return OrderPosition(itemNodes[item]);
 }
 
-
-// Check or uncheck a menu item
-bool ofxWinMenu::SetPopupItem(std::string ItemName, bool bChecked)
+//
+// Radio groups
+//
+// One item of a radio group is selected and shown with a radio bullet.
+// Selecting an item, by the menu or by SetPopupItem, unchecks the item
+// selected before. The selection is saved as one key, the group name
+// with the name of the selected item.
+//
+//     ofxWinMenuGroup group = menu->AddRadioGroup("Blend mode");
+//     menu->AddRadioItem(hPopup, group, "Normal", true);
+//     menu->AddRadioItem(hPopup, group, "Add");
+//     menu->AddRadioItem(hPopup, group, "Multiply");
+//
+// Returns the group, or an existing group of the same name.
+// The group is a separate type from item numbers, so that
+// it cannot be given to SetPopupItem by mistake.
+ofxWinMenuGroup ofxWinMenu::AddRadioGroup(std::string GroupName)
 {
-	if(g_hwnd == NULL || g_hMenu == NULL || !IsMenu(g_hMenu)) return false;
-	
-	int nItems = (int)itemIDs.size();
-	if(nItems > 0) {
-		// Find the item number
-		for(int i=0; i<nItems; i++) {
-			if(ItemName == itemNames.at(i)) {
-				// Which popup menu is the item in
-				HMENU hSubMenu = subMenus.at(i);
-				if(hSubMenu) {
-					// How many items in the submenu
-					int nPopupItems = GetMenuItemCount(hSubMenu);
-					// Loop through the popup items to find a match
-					if(nPopupItems > 0) {
-						char itemstring[MAX_PATH];
-						for(int j=0; j<nPopupItems; j++) {
-							GetMenuStringA(hSubMenu, j, (LPSTR)itemstring, MAX_PATH, MF_BYPOSITION);
-							if(ItemName == itemstring) {
-								if(bChecked)
-									CheckMenuItem(hSubMenu, j, MF_BYPOSITION | MF_CHECKED);
-								else
-									CheckMenuItem(hSubMenu, j, MF_BYPOSITION | MF_UNCHECKED);
-								isChecked.at(i) = bChecked;
-								return true;
-							}
-						}
-					}
-				}
-			}
-		}
+	for(int i = 0; i < (int)radioGroups.size(); i++) {
+		if(radioGroups[i].name == GroupName)
+			return { i };
 	}
-	return false;
+	radioGroups.push_back({ GroupName, -1 });
+	return { (int)radioGroups.size() - 1 };
 }
 
-// Enable or disable a popup item
-bool ofxWinMenu::EnablePopupItem(std::string ItemName, bool bEnabled)
+// Add an item to a radio group and return the item number, -1 if not added
+int ofxWinMenu::AddRadioItem(HMENU hSubMenu, ofxWinMenuGroup group, std::string ItemName, bool bSelected)
 {
-	if (g_hwnd == NULL || g_hMenu == NULL || !IsMenu(g_hMenu)) return false;
-
-	if (itemIDs.size() > 0) {
-		// Find the item number
-		for (int i = 0; i < (int)itemIDs.size(); i++) {
-			if (ItemName == itemNames.at(i)) {
-				if (bEnabled)
-					EnableMenuItem(g_hMenu, i, MF_ENABLED);
-				else
-					EnableMenuItem(g_hMenu, i, MF_DISABLED);
-				return true;
-			}
-		}
+	if(!g_hMenu || !hSubMenu || group.id < 0 || group.id >= (int)radioGroups.size())
+		return -1;
+
+	// The item is checked by the group instead of auto check
+	int item = AddItem(hSubMenu, -1, ItemName, false, false);
+	if(item < 0)
+		return -1;
+	itemGroups[item] = group.id;
+	if(bAutoSave)
+		SetAutoSaveName(item);
+
+	if(!MenuInsertItem(item)) {
+		RemoveItem(item);
+		return -1;
 	}
-	return false;
+	if(bSelected)
+		SetPopupItem(item, true);
+	return item;
 }
 
-// Get the checkmark state of a popup item
-bool ofxWinMenu::GetPopupItem(std::string ItemName)
+// Select an item of a radio group
+bool ofxWinMenu::SelectRadioItem(int item)
 {
-	if (itemIDs.size() > 0) {
-		// Find the item number
-		for (int i = 0; i < (int)itemIDs.size(); i++) {
-			if (ItemName == itemNames.at(i)) {
-				return isChecked[i];
-			}
-		}
-	}
-	return false;
+	if(!IsItem(item) || itemGroups[item] < 0)
+		return false;
+	return SetPopupItem(item, true);
 }
 
-// Save popup item states to an initialization file
-void ofxWinMenu::Save(std::string filename, bool bOverWrite)
+bool ofxWinMenu::SelectRadioItem(std::string ItemName)
 {
-	char tmp[MAX_PATH]{};
-	std::string inipath;
+	return SelectRadioItem(FindItem(ItemName));
+}
 
-	// Check extension
-	size_t pos = filename.rfind(".ini");
-	if (pos == std::string::npos) {
-		// No extension or not ".ini"
-		pos = filename.rfind(".");
-		if (pos == std::string::npos) {
-			// No extension - add ".ini"
-			filename = filename + ".ini";
-		}
-		else {
-			// Extension not "ini" 
-			// Strip extension
-			filename = filename.substr(0, pos);
-			// Add ".ini"
-			filename = filename + ".ini";
-		}
-	}
+// The selected item of a radio group, -1 if none
+int ofxWinMenu::GetRadioItem(ofxWinMenuGroup group)
+{
+	if(group.id < 0 || group.id >= (int)radioGroups.size())
+		return -1;
+	return radioGroups[group.id].selected;
+}
 
-	// Check for full path
-	if (filename.find('/') != std::string::npos || filename.find('\\') != std::string::npos) {
-		inipath = filename;
-	}
-	else {
-		// filename only - add full path - (bin\data directory)
-		char path[MAX_PATH]{};
-		GetModuleFileNameA(NULL, path, MAX_PATH);
-		PathRemoveFileSpecA(path);
-		inipath = path;
-		inipath = inipath + "\\data\\" + filename;
-	}
+//
+// Keyboard accelerators
+//
+// A key, with "Ctrl", "Shift" and "Alt" if required, selects a menu item
+// the same way as the menu. The key is shown in the item text.
+//
+//     menu->SetItemAccelerator(item, "Ctrl+I");
+//     menu->SetItemAccelerator("Full screen", "F11");
+//
+// An empty key removes the accelerator of the item.
+// Keys that are not accelerators are passed on to ofApp.
+//
+bool ofxWinMenu::SetItemAccelerator(int item, std::string key)
+{
+	if(!IsItem(item) || itemNames[item].empty())
+		return false;
 
-	// Check if file exists if bOverWrite is false
-	if (!bOverWrite && _access(inipath.c_str(), 0) != -1) {
-		sprintf_s(tmp, MAX_PATH, "%s exists - overwrite?", filename.c_str());
-		if (MessageBoxA(NULL, tmp, "Warning", MB_YESNO | MB_TOPMOST) == IDNO)
-			return;
+	int code = 0;
+	if(!key.empty()) {
+		code = ParseAccelerator(key);
+		if(code < 0) {
+			printf("ofxWinMenu::SetItemAccelerator\n\"%s\" is not a key\n", key.c_str());
+			return false;
+		}
+		// A key can select one item
+		auto it = keyIndex.find(code);
+		if(it != keyIndex.end() && it->second != item)
+			SetItemAccelerator(it->second, "");
 	}
 
-	if (itemIDs.size() > 0) {
-		// Find the item number
-		for (int i = 0; i < (int)itemIDs.size(); i++) {
-
-			if (autoCheck[i]) {
-				// For debugging
-				// sprintf_s(tmp, MAX_PATH, "Save : item [%s] = %d\n", itemNames.at(i).c_str(), (bool)isChecked[i]);
-				// MessageBoxA(NULL, tmp, "Save", MB_OK | MB_TOPMOST);
-				if (isChecked[i])
-					WritePrivateProfileStringA((LPCSTR)"Menu", (LPCSTR)itemNames.at(i).c_str(), (LPCSTR)"1", (LPCSTR)inipath.c_str());
-				else
-					WritePrivateProfileStringA((LPCSTR)"Menu", (LPCSTR)itemNames.at(i).c_str(), (LPCSTR)"0", (LPCSTR)inipath.c_str());
-			}
-		}
+	// Replace the key of the item
+	if(itemKeys[item] != 0)
+		keyIndex.erase(itemKeys[item]);
+	itemKeys[item] = code;
+	if(code != 0)
+		keyIndex[code] = item;
+
+	// Show the key in the item text
+	std::string text = GetItemText(item);
+	if(!itemMirrors.empty()) {
+		auto range = itemMirrors.equal_range(item);
+		for(auto it = range.first; it != range.second; ++it)
+			backend->SetItemText(it->second.first, item, MF_BYCOMMAND, text.c_str());
 	}
+	return backend->SetItemText(subMenus[item], OrderPosition(itemNodes[item]), MF_BYPOSITION, text.c_str());
 }
 
-// Load item states from an initialization file
-bool ofxWinMenu::Load(std::string filename)
+bool ofxWinMenu::SetItemAccelerator(std::string ItemName, std::string key)
 {
-	char tmp[MAX_PATH]{};
-	std::string inipath="";
+	return SetItemAccelerator(FindItem(ItemName), key);
+}
 
-	// Check extension
-	size_t pos = filename.rfind(".ini");
-	if (pos == std::string::npos) {
-		// No extension or not ".ini"
-		pos = filename.rfind(".");
-		if (pos == std::string::npos) {
-			// No extension - add ".ini"
-			filename = filename + ".ini";
+//
+// Key code of an accelerator, -1 if not a key
+//
+// The key code is the virtual key code with Ctrl, Shift and Alt in bits 16-18.
+// The key is a letter, a number, a function key "F1" to "F24" or one of
+// "Space", "Enter", "Esc", "Tab", "Backspace", "Delete", "Insert", "Home",
+// "End", "PageUp", "PageDown", "Left", "Right", "Up", "Down".
+// Names are not case sensitive.
+//
+int ofxWinMenu::ParseAccelerator(const std::string &key)
+{
+	static const std::pair<const char *, int> keyNames[] = {
+		{ "space", VK_SPACE }, { "enter", VK_RETURN }, { "return", VK_RETURN },
+		{ "esc", VK_ESCAPE }, { "escape", VK_ESCAPE }, { "tab", VK_TAB },
+		{ "backspace", VK_BACK }, { "delete", VK_DELETE }, { "del", VK_DELETE },
+		{ "insert", VK_INSERT }, { "ins", VK_INSERT }, { "home", VK_HOME }, { "end", VK_END },
+		{ "pageup", VK_PRIOR }, { "pgup", VK_PRIOR }, { "pagedown", VK_NEXT }, { "pgdn", VK_NEXT },
+		{ "left", VK_LEFT }, { "right", VK_RIGHT }, { "up", VK_UP }, { "down", VK_DOWN }
+	};
+
+	int code = 0;
+	size_t start = 0;
+	while(start <= key.size()) {
+		size_t end = key.find('+', start);
+		// "Ctrl++" is the plus key
+		if(end == start && start + 1 == key.size())
+			end = std::string::npos;
+		std::string part = IniLower(IniTrim(key.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+		if(end != std::string::npos) {
+			// Modifier
+			if(part == "ctrl" || part == "control")
+				code |= keyCtrl;
+			else if(part == "shift")
+				code |= keyShift;
+			else if(part == "alt")
+				code |= keyAlt;
+			else
+				return -1;
+			start = end + 1;
+			continue;
+		}
+		// Key
+		int vk = 0;
+		if(part.size() == 1 && isalnum((unsigned char)part[0]))
+			vk = toupper((unsigned char)part[0]);
+		else if(part == "+")
+			vk = VK_OEM_PLUS;
+		else if(part == "-")
+			vk = VK_OEM_MINUS;
+		else if(part.size() > 1 && part[0] == 'f' && isdigit((unsigned char)part[1])) {
+			int n = atoi(part.c_str() + 1);
+			if(n >= 1 && n <= 24 && part.find_first_not_of("0123456789", 1) == std::string::npos)
+				vk = VK_F1 + n - 1;
 		}
 		else {
-			// Extension not "ini"
-			printf("ofxWinMenu::Load\n%s is not an initialization file\n", filename.c_str());
-			return false;
+			for(const auto &name : keyNames) {
+				if(part == name.first) {
+					vk = name.second;
+					break;
+				}
+			}
 		}
+		if(vk == 0)
+			return -1;
+		return code | vk;
 	}
+	return -1;
+}
 
-	// Check for full path
-	if (filename.find('/') != std::string::npos || filename.find('\\') != std::string::npos) {
-		inipath = filename;
-	}
-	else {
-		// filename only - add full path - (bin\data directory)
-		char path[MAX_PATH]{};
-		GetModuleFileNameA(NULL, path, MAX_PATH);
-		PathRemoveFileSpecA(path);
-		inipath = path;
-		inipath = inipath + "\\data\\" + filename;
+// Text of an accelerator key code, such as "Ctrl+Shift+S"
+std::string ofxWinMenu::AcceleratorText(int code)
+{
+	static const std::pair<int, const char *> keyNames[] = {
+		{ VK_SPACE, "Space" }, { VK_RETURN, "Enter" }, { VK_ESCAPE, "Esc" }, { VK_TAB, "Tab" },
+		{ VK_BACK, "Backspace" }, { VK_DELETE, "Del" }, { VK_INSERT, "Ins" }, { VK_HOME, "Home" },
+		{ VK_END, "End" }, { VK_PRIOR, "PgUp" }, { VK_NEXT, "PgDn" }, { VK_LEFT, "Left" },
+		{ VK_RIGHT, "Right" }, { VK_UP, "Up" }, { VK_DOWN, "Down" }, { VK_OEM_PLUS, "+" }, { VK_OEM_MINUS, "-" }
+	};
+
+	if(code <= 0)
+		return "";
+
+	std::string text;
+	if(code & keyCtrl) text += "Ctrl+";
+	if(code & keyShift) text += "Shift+";
+	if(code & keyAlt) text += "Alt+";
+
+	int vk = code & 0xFFFF;
+	if((vk >= 'A' && vk <= 'Z') || (vk >= '0' && vk <= '9'))
+		return text + (char)vk;
+	if(vk >= VK_F1 && vk < VK_F1 + 24)
+		return text + "F" + std::to_string(vk - VK_F1 + 1);
+	for(const auto &name : keyNames) {
+		if(vk == name.first)
+			return text + name.second;
 	}
+	return text + "?";
+}
 
-	// Check that the file exists in case an extension was added
-	if (_access(inipath.c_str(), 0) == -1) {
-		printf("ofxWinMenu::Load\nInitialization file \"%s\" not found.\n", inipath.c_str());
+// Select the item of an accelerator key
+// Returns false if the key is not an accelerator
+bool ofxWinMenu::KeyCommand(int vk)
+{
+	if(keyIndex.empty())
+		return false;
+
+	int code = vk;
+	if(GetKeyState(VK_CONTROL) < 0) code |= keyCtrl;
+	if(GetKeyState(VK_SHIFT) < 0) code |= keyShift;
+	if(GetKeyState(VK_MENU) < 0) code |= keyAlt;
+
+	auto it = keyIndex.find(code);
+	if(it == keyIndex.end())
+		return false;
+
+	// A disabled item is not selected, but the key is used
+	if(isEnabled[it->second])
+		MenuCommand(it->second);
+	return true;
+}
+
+//
+// Context menus
+//
+// A context menu is created once and shown when required, for example
+// when the right mouse button is pressed :
+//
+//     hContext = menu->CreateContextMenu();
+//     menu->AddContextItem(hContext, "Show info");
+//     menu->AddContextItem(hContext, "Full screen");
+//     menu->AddPopupSeparator(hContext);
+//     menu->AddPopupItem(hContext, "Reset view", false, false);
+//
+//     void ofApp::mousePressed(int x, int y, int button) {
+//         if(button == 2) menu->ShowContextMenu(hContext);
+//     }
+//
+// An item of the window menu added by AddContextItem has the same item
+// number in the context menu, and the same checked and enabled state,
+// item function and accelerator key. Other items, separators and popup
+// menus can be added to a context menu the same as a popup menu.
+//
+HMENU ofxWinMenu::CreateContextMenu()
+{
+	HMENU hContextMenu = backend->CreatePopup();
+	if(hContextMenu)
+		contextMenus.push_back(hContextMenu);
+	return hContextMenu;
+}
+
+// Add an existing item to a context menu
+bool ofxWinMenu::AddContextItem(HMENU hContextMenu, int item)
+{
+	if(!hContextMenu || !IsItem(item) || itemNames[item].empty() || subMenus[item] == hContextMenu)
 		return false;
+
+	// An item is added once to each menu
+	auto range = itemMirrors.equal_range(item);
+	for(auto it = range.first; it != range.second; ++it) {
+		if(it->second.first == hContextMenu)
+			return false;
 	}
 
-	// Load item states
-	// Only those saved in the ini file are changed
-	if (itemIDs.size() > 0) {
-		for (int i = 0; i < (int)itemIDs.size(); i++) {
-			if (GetPrivateProfileStringA((LPCSTR)"Menu", (LPCSTR)(LPCSTR)itemNames.at(i).c_str(), NULL, (LPSTR)tmp, MAX_PATH, (LPCSTR)inipath.c_str()) > 0) {
-				if (tmp[0]) isChecked[i] = (bool)(atoi(tmp) == 1);
-				// For debugging
-				// sprintf_s(tmp, MAX_PATH, "Menu Load : item [%s] = %d\n", itemNames.at(i).c_str(), (bool)isChecked[i]);
-				// MessageBoxA(NULL, tmp, "Load", MB_OK | MB_TOPMOST);
-				SetPopupItem(itemNames.at(i), isChecked[i]);
-				// Return new value to ofApp
-				MenuFunction(itemNames.at(i), isChecked[i]);
-			}
-		}
+	int node = NewOrderNode(hContextMenu, -1);
+	OrderInsert(node, -1);
+	if(!MenuInsertMirror(item, hContextMenu, node)) {
+		OrderRemove(node);
+		return false;
 	}
+	itemMirrors.emplace(item, std::make_pair(hContextMenu, node));
 	return true;
 }
 
-// ofApp Function for return of memu item selection
-void ofxWinMenu::CreateMenuFunction(void(ofApp::*function)(std::string title, bool bChecked))
+bool ofxWinMenu::AddContextItem(HMENU hContextMenu, std::string ItemName)
 {
-	pAppMenuFunction = function; // Return function in ofApp
+	return AddContextItem(hContextMenu, FindItem(ItemName));
 }
 
-// Pass back the menu item title and state to ofApp
-// by calling the function set by "CreateMenuFunction"
-void ofxWinMenu::MenuFunction(std::string title, bool bChecked)
+// Show a context menu at the cursor position
+// The selected item is returned to ofApp the same as the window menu
+bool ofxWinMenu::ShowContextMenu(HMENU hContextMenu)
+{
+	if(!hContextMenu || !g_hwnd)
+		return false;
+	return backend->TrackPopup(hContextMenu, g_hwnd);
+}
+
+// Item text shown by the menu, with the accelerator key if any
+std::string ofxWinMenu::GetItemText(int item)
 {
-	(pApp->*pAppMenuFunction)(title, bChecked); 
+	if(itemKeys[item] == 0)
+		return itemNames[item];
+	return itemNames[item] + "\t" + AcceleratorText(itemKeys[item]);
 }
 
+// Item separator
+// The separator is added after the items, separators and popup menus
+// already in the popup menu, which can be at any depth.
+bool ofxWinMenu::AddPopupSeparator(HMENU hSubMenu)
+{
+	if(g_hMenu && hSubMenu) {
+		// A separator has no name
+		int item = AddItem(hSubMenu, -1, "", false, false);
+		if(MenuInsertItem(item))
+			return true;
+		if(item >= 0)
+			RemoveItem(item);
+	}
+	return false;
+}
 
 //
-// Our local window message callback procedure
+// Create a menu from a text description
+//
+// Each line is a popup menu, an item or a separator.
+// Popup menus can contain other popup menus.
 //
-LRESULT CALLBACK ofxWinMenuWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+//     File {                 - popup menu, ends with "}"
+//         Open | noauto      - item, not auto checked
+//         Recent {           - popup menu within the File menu
+//             Item 1 | checked
+//         }
+//         -                  - separator
+//         Exit | noauto
+//     }
+//     View {
+//         Show info | checked
+//         Show on top
+//         Full screen | noauto disabled
+//     }
+//
+// Item options follow "|" and can be "checked", "noauto" or "disabled",
+// separated by spaces. Any other word is an error.
+// Empty lines and lines starting with ";" are ignored.
+//
+// The menu is created in one pass. Item positions are counted
+// while the menu is created instead of being found from each popup menu.
+// The window menu is created if necessary. SetWindowMenu is then
+// used to set the menu to the application window.
+//
+bool ofxWinMenu::CreateMenuFromText(std::string text)
 {
-	HMENU hSubMenu = NULL;
-	char title[MAX_PATH];
-	int ID = 0;
+	// Menu definition from the text
+	std::vector<ofxWinMenuDef> def;
+	std::vector<std::string> names; // Names used by the definition
+	int nLines = (int)std::count(text.begin(), text.end(), '\n') + 1;
+	def.reserve(nLines);
+	names.reserve(nLines); // Names are not moved
+	int nPopups = 0; // Popup menus not ended
+
+	int nLine = 0;
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) end = text.size();
+		std::string line = IniTrim(text.substr(start, end - start));
+		start = end + 1;
+		nLine++;
+
+		if (line.empty() || line[0] == ';')
+			continue;
+
+		// End of popup menu
+		if (line == "}") {
+			if (nPopups == 0) {
+				printf("ofxWinMenu::CreateMenuFromText\nLine %d : unexpected \"}\"\n", nLine);
+				return false;
+			}
+			nPopups--;
+			def.push_back({ OFXMENU_END });
+			continue;
+		}
 
-	// Menu item ID
-	int wmId = (int)LOWORD(wParam);
+		// Popup menu
+		if (line.back() == '{') {
+			names.push_back(IniTrim(line.substr(0, line.size() - 1)));
+			def.push_back({ OFXMENU_POPUP, names.back().c_str() });
+			nPopups++;
+			continue;
+		}
+
+		// The top level menu contains only popup menus
+		if (nPopups == 0) {
+			printf("ofxWinMenu::CreateMenuFromText\nLine %d : item outside a popup menu\n", nLine);
+			return false;
+		}
+
+		// Separator
+		if (line == "-") {
+			def.push_back({ OFXMENU_SEPARATOR });
+			continue;
+		}
+
+		// Item and options
+		ofxWinMenuDef item{ OFXMENU_ITEM };
+		size_t bar = line.rfind('|');
+		if (bar != std::string::npos) {
+			std::string options = IniLower(line.substr(bar + 1));
+			// Each option is a whole word separated by spaces or tabs
+			size_t pos = 0;
+			while ((pos = options.find_first_not_of(" \t", pos)) != std::string::npos) {
+				size_t next = options.find_first_of(" \t", pos);
+				if (next == std::string::npos) next = options.size();
+				std::string option = options.substr(pos, next - pos);
+				pos = next;
+				if (option == "checked")
+					item.bChecked = true;
+				else if (option == "noauto")
+					item.bAutoCheck = false;
+				else if (option == "disabled")
+					item.bEnabled = false;
+				else {
+					printf("ofxWinMenu::CreateMenuFromText\nLine %d : unknown option \"%s\"\n", nLine, option.c_str());
+					return false;
+				}
+			}
+			line = IniTrim(line.substr(0, bar));
+		}
+		names.push_back(line);
+		item.name = names.back().c_str();
+		def.push_back(item);
+	}
+
+	if (nPopups > 0) {
+		printf("ofxWinMenu::CreateMenuFromText\nMissing \"}\"\n");
+		return false;
+	}
+
+	return BuildMenu(def.data(), def.size());
+}
+
+//
+// Create a menu from a definition
+//
+// The item numbers are the positions of the items and separators
+// in the definition, so the menu must be created before any other items
+// are added, or after DestroyWindowMenu has removed them. The item numbers can then be found at compile time by
+// ofxWinMenuID and used as case labels of an item number menu function.
+// See ofxWinMenu.h.
+//
+bool ofxWinMenu::CreateMenuFromDef(const ofxWinMenuDef *def, size_t nDefs)
+{
+	// Removed item numbers are used again from the lowest
+	if (itemNames.size() != freeItems.size()) {
+		printf("ofxWinMenu::CreateMenuFromDef\nThe menu already has items\n");
+		return false;
+	}
+	return BuildMenu(def, nDefs);
+}
+
+//
+// Create menu items from a definition in one pass
+//
+// Each entry is added at the end of the popup menu being created.
+//
+bool ofxWinMenu::BuildMenu(const ofxWinMenuDef *def, size_t nDefs)
+{
+	if (!g_hMenu)
+		CreateWindowMenu();
+	if (!g_hMenu)
+		return false;
+
+	ReserveItems((int)(itemNames.size() + nDefs));
+
+	// Popup menus being created
+	std::vector<HMENU> popups;
+	popups.push_back(g_hMenu);
+
+	for (size_t i = 0; i < nDefs; i++) {
+		HMENU hMenu = popups.back();
+
+		switch (def[i].type) {
+
+			case OFXMENU_POPUP: {
+				HMENU hPopup = AddPopupMenu(hMenu, def[i].name);
+				if (!hPopup) return false;
+				popups.push_back(hPopup);
+				break;
+			}
+
+			case OFXMENU_END:
+				if (popups.size() < 2) return false;
+				popups.pop_back();
+				break;
+
+			case OFXMENU_SEPARATOR: {
+				if (popups.size() < 2) return false;
+				int item = AddItem(hMenu, -1, "", false, false);
+				if (!MenuInsertItem(item)) {
+					if (item >= 0) RemoveItem(item);
+					return false;
+				}
+				break;
+			}
+
+			case OFXMENU_ITEM: {
+				if (popups.size() < 2) return false;
+				int item = AddItem(hMenu, -1, def[i].name, def[i].bChecked, def[i].bAutoCheck);
+				if (!MenuInsertItem(item)) {
+					if (item >= 0) RemoveItem(item);
+					return false;
+				}
+				if (def[i].bAutoCheck && def[i].bChecked)
+					MenuCheckItem(item);
+				if (!def[i].bEnabled) {
+					SetItemEnabled(item, false);
+					MenuEnableItem(item);
+				}
+				break;
+			}
+		}
+	}
+	return (popups.size() == 1);
+}
+
+// Create a menu from a text file
+// A file name without a path is in the "bin\data" folder
+bool ofxWinMenu::CreateMenuFromFile(std::string filename)
+{
+	std::string path = GetIniPath(filename);
+	std::ifstream infile(path, std::ios::binary);
+	if (!infile.is_open()) {
+		printf("ofxWinMenu::CreateMenuFromFile\nMenu file \"%s\" not found.\n", path.c_str());
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+	return CreateMenuFromText(text);
+}
+
+// Set the menu to the application
+bool ofxWinMenu::SetWindowMenu()
+{
+	if(g_hwnd && g_hMenu)
+		return backend->SetWindowMenu(g_hwnd, g_hMenu);
+	else
+		return false;
+}
+
+// Closing the window ends the application
+// Set for the first window that has a menu object
+void ofxWinMenu::SetQuitOnClose(bool bQuit)
+{
+	bQuitOnClose = bQuit;
+}
+
+// Remove the menu from the application
+bool ofxWinMenu::RemoveWindowMenu()
+{
+	if(g_hwnd)
+		return backend->SetWindowMenu(g_hwnd, NULL);
+	else
+		return false;
+}
+
+// Destroy the menu - not normally used
+// The items of the menu and its popup menus are removed, so that a different
+// menu created next finds its own items by name. Context menus are kept.
+bool ofxWinMenu::DestroyWindowMenu()
+{
+	if(!g_hMenu)
+		return false;
+	bool bDestroyed = backend->DestroyMenuHandle(g_hMenu);
+	g_hMenu = NULL;
+
+	// Changes not yet saved are saved before the items are removed
+	bool bWasAutoSave = bAutoSave;
+	StopAutoSave();
+
+	// Items of menus that no longer exist, with any copies in context menus
+	for(int item = 0; item < (int)subMenus.size(); item++) {
+		if(subMenus[item] && !backend->IsMenuHandle(subMenus[item])) {
+			MenuRemoveItem(item);
+			RemoveItem(item);
+		}
+	}
+
+	// Popup menus that no longer exist
+	for(auto it = popupMenus.begin(); it != popupMenus.end(); ) {
+		if(!backend->IsMenuHandle(it->first)) {
+			OrderRemove(it->second.node);
+			lazyIndex.erase(it->first);
+			it = popupMenus.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	for(auto it = orderRoots.begin(); it != orderRoots.end(); ) {
+		if(!backend->IsMenuHandle(it->first))
+			it = orderRoots.erase(it);
+		else
+			++it;
+	}
+
+	if(bWasAutoSave)
+		SetAutoSave(autoSavePath, (int)autoSaveQuiet.count());
+	return bDestroyed;
+}
+
+
+// Check or uncheck a menu item
+bool ofxWinMenu::SetPopupItem(std::string ItemName, bool bChecked)
+{
+	return SetPopupItem(FindItem(ItemName), bChecked);
+}
+
+// Enable or disable a popup item
+bool ofxWinMenu::EnablePopupItem(std::string ItemName, bool bEnabled)
+{
+	return EnablePopupItem(FindItem(ItemName), bEnabled);
+}
+
+// Get the checkmark state of a popup item
+bool ofxWinMenu::GetPopupItem(std::string ItemName)
+{
+	return GetPopupItem(FindItem(ItemName));
+}
+
+// Check or uncheck a menu item by item number
+bool ofxWinMenu::SetPopupItem(int item, bool bChecked)
+{
+	if(!IsItem(item)) return false;
+	if(nUpdates == 0 && !IsMenuValid()) return false;
+
+	// A radio item is the selected item of its group.
+	// The item selected before is unchecked.
+	if(itemGroups[item] >= 0) {
+		radioGroup &group = radioGroups[itemGroups[item]];
+		if(bChecked && group.selected != item) {
+			int previous = group.selected;
+			group.selected = item;
+			if(previous >= 0)
+				SetPopupItem(previous, false);
+		}
+		else if(!bChecked && group.selected == item) {
+			group.selected = -1;
+		}
+	}
+
+	// Change the menu when the update ends
+	if(nUpdates > 0) {
+		SetItemChecked(item, bChecked);
+		SetItemPending(item);
+		return true;
+	}
+
+	SetItemChecked(item, bChecked);
+	MenuCheckItem(item);
+
+	return true;
+}
+
+// Enable or disable a popup item by item number
+bool ofxWinMenu::EnablePopupItem(int item, bool bEnabled)
+{
+	if (!IsItem(item)) return false;
+
+	// Change the menu when the update ends
+	if (nUpdates > 0) {
+		SetItemEnabled(item, bEnabled);
+		SetItemPending(item);
+		return true;
+	}
+
+	if (!IsMenuValid()) return false;
+
+	SetItemEnabled(item, bEnabled);
+	MenuEnableItem(item);
+
+	return true;
+}
+
+// Get the checkmark state of a popup item by item number
+bool ofxWinMenu::GetPopupItem(int item)
+{
+	if (item < 0 || item >= isChecked.size()) return false;
+	return isChecked[item];
+}
+
+//
+// Snapshot of item flags
+//
+// The checked and enabled flags of all items are copied to the vectors,
+// 64 items for each word. Item "i" is bit (i % 64) of word (i / 64).
+// The copy is made again if the flags are changed during the copy,
+// so the snapshot is consistent without a lock.
+//
+// Any thread can take a snapshot, for example once each frame
+// by a render or audio thread.
+//
+int ofxWinMenu::Snapshot(std::vector<uint64_t> &checked, std::vector<uint64_t> &enabled)
+{
+	int nItems = 0;
+	unsigned int sequence = 0;
+	do {
+		// Wait while a change is made
+		while((sequence = flagSequence.load(std::memory_order_acquire)) & 1)
+			std::this_thread::yield();
+		nItems = isChecked.size();
+		int nWords = (nItems + 63) / 64;
+		checked.resize(nWords);
+		enabled.resize(nWords);
+		for(int i = 0; i < nWords; i++) {
+			checked[i] = isChecked.word(i);
+			enabled[i] = isEnabled.word(i);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while(flagSequence.load(std::memory_order_relaxed) != sequence);
+
+	return nItems;
+}
+
+// Find the item number of a named item
+int ofxWinMenu::FindItem(const std::string &ItemName)
+{
+	auto range = itemIndex.equal_range(ItemName);
+	if (range.first == range.second)
+		return -1;
+	// The first item if more than one has the name
+	int item = range.first->second;
+	for (auto it = std::next(range.first); it != range.second; ++it)
+		item = (std::min)(item, it->second);
+	return item;
+}
+
+// The item number is in use and has not been removed
+bool ofxWinMenu::IsItem(int item)
+{
+	return (item >= 0 && item < (int)subMenus.size() && subMenus[item] != NULL);
+}
+
+//
+// Lazy popup menu
+//
+// The items of a lazy popup menu are not created until the menu is about
+// to open. They are then returned by the "provider" function :
+//
+//     void provider(std::vector<std::string> &items)
+//
+// For example, a list of recent files or presets. The items are
+// kept for the next time the menu opens and are created again
+// only after InvalidateLazyPopupMenu.
+//
+// When an item is selected the "function" is called with the item
+// index and name :
+//
+//     void function(int index, const std::string &name)
+//
+// The number of items created is limited to "maxItems", or 4096 if
+// maxItems is 0. Up to 8 lazy popup menus can be added. Lazy menu items
+// are not auto checked and are not saved.
+//
+// Command IDs are 16 bit. Each lazy popup menu reserves "maxItems" command
+// IDs below those of the lazy popup menus added before it, starting from
+// the top of the range, and items can then be added only below them.
+// The popup menu is not added if the IDs are already used by items.
+//
+HMENU ofxWinMenu::AddLazyPopupMenu(HMENU hMenu, std::string menuName,
+	std::function<void(std::vector<std::string> &items)> provider,
+	std::function<void(int index, const std::string &name)> function, int maxItems)
+{
+	if ((int)lazyMenus.size() >= maxLazyMenus || !provider)
+		return NULL;
+
+	maxItems = (maxItems > 0 && maxItems < lazyBlockSize) ? maxItems : lazyBlockSize;
+	if (lazyFirstID - maxItems < (int)itemNames.size()) {
+		printf("ofxWinMenu::AddLazyPopupMenu\nNo command IDs left for \"%s\"\n", menuName.c_str());
+		return NULL;
+	}
+
+	HMENU hPopup = AddPopupMenu(hMenu, menuName);
+	if (!hPopup)
+		return NULL;
+
+	lazyMenu lazy;
+	lazy.hMenu = hPopup;
+	lazy.provider = provider;
+	lazy.function = function;
+	lazy.maxItems = maxItems;
+	lazy.firstID = lazyFirstID - maxItems;
+	lazyFirstID = lazy.firstID;
+	lazy.generation = 1; // Not yet created
+	lazy.created = 0;
+	lazyIndex[hPopup] = (int)lazyMenus.size();
+	lazyMenus.push_back(lazy);
+
+	return hPopup;
+}
+
+// The items of a lazy popup menu are created again when it next opens
+bool ofxWinMenu::InvalidateLazyPopupMenu(HMENU hPopup)
+{
+	auto it = lazyIndex.find(hPopup);
+	if (it == lazyIndex.end())
+		return false;
+	lazyMenus[it->second].generation++;
+	return true;
+}
+
+// Create the items of a lazy popup menu if necessary
+bool ofxWinMenu::InitLazyPopupMenu(HMENU hPopup)
+{
+	auto it = lazyIndex.find(hPopup);
+	if (it == lazyIndex.end())
+		return false;
+
+	lazyMenu &lazy = lazyMenus[it->second];
+	if (lazy.created == lazy.generation)
+		return true; // Not changed
+
+	// Remove the old items
+	for (int i = backend->GetItemCount(hPopup) - 1; i >= 0; i--)
+		backend->DeleteItem(hPopup, i, MF_BYPOSITION);
+
+	// Get the new items
+	lazy.items.clear();
+	lazy.provider(lazy.items);
+	if ((int)lazy.items.size() > lazy.maxItems)
+		lazy.items.resize(lazy.maxItems);
+
+	// Each lazy menu has a block of command IDs
+	for (int i = 0; i < (int)lazy.items.size(); i++)
+		backend->AppendItem(hPopup, MF_STRING, lazy.firstID + i, lazy.items[i].c_str());
+
+	lazy.created = lazy.generation;
+	return true;
+}
+
+// Lazy popup menu with the block of a command ID, -1 if none
+int ofxWinMenu::LazyMenuFromID(int id)
+{
+	for (int menu = 0; menu < (int)lazyMenus.size(); menu++) {
+		if (id >= lazyMenus[menu].firstID && id < lazyMenus[menu].firstID + lazyMenus[menu].maxItems)
+			return menu;
+	}
+	return -1;
+}
+
+// Selection of a lazy popup menu item
+bool ofxWinMenu::LazyMenuCommand(int id)
+{
+	int menu = LazyMenuFromID(id);
+	if (menu < 0)
+		return false;
+	int index = id - lazyMenus[menu].firstID;
+	if (index >= (int)lazyMenus[menu].items.size())
+		return false;
+	if (lazyMenus[menu].function)
+		lazyMenus[menu].function(index, lazyMenus[menu].items[index]);
+	return true;
+}
+
+//
+// Update
+//
+// Item changes by SetPopupItem and EnablePopupItem between BeginUpdate
+// and EndUpdate are recorded but the menu is not changed. EndUpdate
+// then changes only those items that are different from the menu,
+// once for each item, however many times it was changed.
+//
+//     menu->BeginUpdate();
+//     menu->SetPopupItem("Item 1", true);
+//     menu->EnablePopupItem("Item 2", false);
+//     menu->EndUpdate();
+//
+// Updates can be nested and the menu is changed by the last EndUpdate.
+// If the menu is not valid, EndUpdate returns false and the changes are
+// kept for the next update that ends with a valid menu.
+//
+void ofxWinMenu::BeginUpdate()
+{
+	nUpdates++;
+}
+
+bool ofxWinMenu::EndUpdate()
+{
+	if(nUpdates == 0) return false;
+	if(--nUpdates > 0) return true;
+
+	// The changes are kept until an update ends with a valid menu
+	if(!IsMenuValid())
+		return false;
+
+	int nCalls = 0;
+	for(int item : updateItems) {
+		isPending[item] = false;
+		if(!IsItem(item)) continue;
+		if(menuChecked[item] != isChecked[item]) {
+			MenuCheckItem(item);
+			nCalls++;
+		}
+		if(menuEnabled[item] != isEnabled[item]) {
+			MenuEnableItem(item);
+			nCalls++;
+		}
+	}
+	updateItems.clear();
+
+	if(nCalls > 0)
+		backend->RedrawMenuBar(g_hwnd);
+
+	// Each change would otherwise have changed the menu
+	nUpdateSaved += nUpdateCalls - nCalls;
+	nUpdateCalls = 0;
+
+	return true;
+}
+
+// Number of menu changes saved by updates
+int ofxWinMenu::GetUpdateSaved()
+{
+	return nUpdateSaved;
+}
+
+//
+// Posted item changes
+//
+// Windows menus must only be changed by the thread that owns the window.
+// Other threads can post item changes, which are made by the window
+// thread together in one update. Any number of threads can post changes
+// without waiting for each other or for the window thread.
+//
+// A message is posted to the window when the first change is posted,
+// so the changes are made by the window procedure without action by ofApp.
+// ProcessPosted can also be called by ofApp, for example in Update().
+//
+void ofxWinMenu::PostSetPopupItem(int item, bool bChecked)
+{
+	PostChange(new postedChange{ nullptr, item, "", false, bChecked });
+}
+
+void ofxWinMenu::PostSetPopupItem(std::string ItemName, bool bChecked)
+{
+	PostChange(new postedChange{ nullptr, -1, ItemName, false, bChecked });
+}
+
+void ofxWinMenu::PostEnablePopupItem(int item, bool bEnabled)
+{
+	PostChange(new postedChange{ nullptr, item, "", true, bEnabled });
+}
+
+void ofxWinMenu::PostEnablePopupItem(std::string ItemName, bool bEnabled)
+{
+	PostChange(new postedChange{ nullptr, -1, ItemName, true, bEnabled });
+}
+
+// Add a change to the posted changes
+void ofxWinMenu::PostChange(postedChange *change)
+{
+	postedChange *head = postedChanges.load(std::memory_order_relaxed);
+	do {
+		change->next = head;
+	} while(!postedChanges.compare_exchange_weak(head, change, std::memory_order_release, std::memory_order_relaxed));
+
+	// Wake the window thread for the first change
+	if(!head && g_hwnd)
+		PostMessageA(g_hwnd, postedMessage, 0, 0);
+}
+
+// Make the posted changes
+// Must be called by the thread that owns the window
+int ofxWinMenu::ProcessPosted()
+{
+	// Take all the posted changes
+	postedChange *change = postedChanges.exchange(nullptr, std::memory_order_acquire);
+	if(!change) return 0;
+
+	// Reverse the list to make the changes in the order they were posted
+	postedChange *first = nullptr;
+	while(change) {
+		postedChange *next = change->next;
+		change->next = first;
+		first = change;
+		change = next;
+	}
+
+	int nChanges = 0;
+	BeginUpdate();
+	while(first) {
+		int item = first->item;
+		if(item < 0)
+			item = FindItem(first->name);
+		if(first->bEnable)
+			EnablePopupItem(item, first->bState);
+		else
+			SetPopupItem(item, first->bState);
+		nChanges++;
+		postedChange *next = first->next;
+		delete first;
+		first = next;
+	}
+	EndUpdate();
+
+	return nChanges;
+}
+
+//
+// Copies of the item states written by Save and SaveAsync
+//
+// Each copy is numbered when it is taken. SaveAsync threads can finish
+// in any order, so a copy is written only if a later copy of the same
+// file has not been written already. The file then always has the
+// states of the last copy taken.
+//
+// The copies are not destroyed with other static objects, so that
+// a menu object that is itself static can still save.
+//
+struct savedCopies {
+	std::mutex mutex;
+	uint64_t nCopies = 0;
+	std::unordered_map<std::string, uint64_t> written; // Last copy written to each file
+};
+
+static savedCopies &SavedCopies()
+{
+	static savedCopies *copies = new savedCopies;
+	return *copies;
+}
+
+static uint64_t NewSavedCopy()
+{
+	savedCopies &copies = SavedCopies();
+	std::lock_guard<std::mutex> lock(copies.mutex);
+	return ++copies.nCopies;
+}
+
+// Returns true if the copy or a later copy has been written
+// The initialization file is not written if bIniFile is false
+static bool WriteSavedCopy(uint64_t copy, const std::string &inipath, bool bIniFile,
+	const std::vector<std::pair<std::string, std::string>> &keys,
+	const std::string &binpath, uint32_t nItems, const std::vector<uint64_t> &data)
+{
+	savedCopies &copies = SavedCopies();
+	std::lock_guard<std::mutex> lock(copies.mutex);
+	uint64_t &written = copies.written[inipath];
+	if (written > copy)
+		return true;
+	bool bSaved = true;
+	if (bIniFile)
+		bSaved = ofxWinMenu::WriteIniSection(inipath, "Menu", keys);
+	if (!binpath.empty())
+		bSaved = ofxWinMenu::WriteBinary(binpath, nItems, data) && bSaved;
+	written = copy;
+	return bSaved;
+}
+
+// Save popup item states to an initialization file
+void ofxWinMenu::Save(std::string filename, bool bOverWrite)
+{
+	char tmp[MAX_PATH]{};
+	std::string inipath;
+
+	// Check extension
+	filename = GetIniName(filename);
+
+	// Add full path if necessary
+	inipath = GetIniPath(filename);
+
+	// Check if file exists if bOverWrite is false
+	if (!bOverWrite && _access(GetSavePath(inipath).c_str(), 0) != -1) {
+		sprintf_s(tmp, MAX_PATH, "%s exists - overwrite?", filename.c_str());
+		if (MessageBoxA(NULL, tmp, "Warning", MB_YESNO | MB_TOPMOST) == IDNO)
+			return;
+	}
+
+	ofxWinMenuTrace::span span(trace.get(), "Save");
+
+	// Item states of the "Menu" section
+	std::vector<std::pair<std::string, std::string>> keys;
+	GetSaveKeys(keys);
+
+	// Binary state file next to the initialization file
+	std::vector<uint64_t> data;
+	uint32_t nItems = 0;
+	std::string binpath;
+	if (bBinaryState) {
+		nItems = GetBinaryData(data);
+		binpath = GetBinaryPath(inipath);
+	}
+
+	// Write all items at once. Other sections of the file are not changed.
+	if (!WriteSavedCopy(NewSavedCopy(), inipath, !bBinaryOnly, keys, binpath, nItems, data))
+		printf("ofxWinMenu::Save\nCould not write \"%s\"\n", GetSavePath(inipath).c_str());
+}
+
+//
+// Save popup item states with a separate thread
+//
+// The item states are copied and the function returns immediately.
+// The file is then written by a separate thread, so that ofApp
+// is not stopped while the file is written.
+//
+// If bOverWrite is false and the file exists, confirmation is requested
+// before the item states are copied, the same as for Save.
+//
+// The returned future becomes true when the file has been written, or false
+// if it could not be written. It is also true if the file was not written
+// because it already has the states of a later Save or SaveAsync.
+// The optional function is also called with the result, by the thread
+// that writes the file, before the future becomes ready.
+//
+// Writes not yet finished are waited for when the menu is deleted,
+// so that the file is complete when ofApp exits.
+//
+std::future<bool> ofxWinMenu::SaveAsync(std::string filename, bool bOverWrite, std::function<void(bool bSaved)> function)
+{
+	std::promise<bool> promise;
+	std::future<bool> future = promise.get_future();
+
+	filename = GetIniName(filename);
+	std::string inipath = GetIniPath(filename);
+
+	// Confirm overwrite by this thread and not by the thread writing the file
+	if (!bOverWrite && _access(GetSavePath(inipath).c_str(), 0) != -1) {
+		char tmp[MAX_PATH]{};
+		sprintf_s(tmp, MAX_PATH, "%s exists - overwrite?", filename.c_str());
+		if (MessageBoxA(NULL, tmp, "Warning", MB_YESNO | MB_TOPMOST) == IDNO) {
+			promise.set_value(false);
+			if (function) function(false);
+			return future;
+		}
+	}
+
+	// Copy of the item states
+	std::vector<std::pair<std::string, std::string>> keys;
+	GetSaveKeys(keys);
+	std::vector<uint64_t> data;
+	uint32_t nItems = 0;
+	if (bBinaryState)
+		nItems = GetBinaryData(data);
+
+	// Write with a separate thread
+	// A later copy may be written first, and this copy is then not written
+	std::string binpath = bBinaryState ? GetBinaryPath(inipath) : "";
+	uint64_t copy = NewSavedCopy();
+	// Writes that have finished are no longer kept
+	saveWrites.erase(std::remove_if(saveWrites.begin(), saveWrites.end(),
+		[](const std::future<void> &write) {
+			return write.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}), saveWrites.end());
+	bool bIniFile = !bBinaryOnly;
+	saveWrites.push_back(std::async(std::launch::async, [inipath, bIniFile, binpath, nItems, keys = std::move(keys), data = std::move(data),
+		copy, function, promise = std::move(promise), trace = trace]() mutable {
+		ofxWinMenuTrace::span span(trace.get(), "SaveAsync");
+		bool bSaved = WriteSavedCopy(copy, inipath, bIniFile, keys, binpath, nItems, data);
+		if (function) function(bSaved);
+		promise.set_value(bSaved);
+	}));
+
+	return future;
+}
+
+// Item states to save, auto check items only
+void ofxWinMenu::GetSaveKeys(std::vector<std::pair<std::string, std::string>> &keys)
+{
+	keys.reserve(keys.size() + itemNames.size());
+	for (int i = 0; i < (int)itemNames.size(); i++) {
+		if (autoCheck[i] && !itemNames[i].empty())
+			keys.emplace_back(itemNames[i], isChecked[i] ? "1" : "0");
+	}
+	// The selected item of each radio group
+	for (const radioGroup &group : radioGroups) {
+		if (group.selected >= 0)
+			keys.emplace_back(group.name, itemNames[group.selected]);
+	}
+}
+
+// Load item states from an initialization file
+bool ofxWinMenu::Load(std::string filename)
+{
+	std::string inipath="";
+
+	// Check extension
+	size_t pos = filename.rfind(".ini");
+	if (pos == std::string::npos) {
+		// No extension or not ".ini"
+		pos = filename.rfind(".");
+		if (pos == std::string::npos) {
+			// No extension - add ".ini"
+			filename = filename + ".ini";
+		}
+		else {
+			// Extension not "ini"
+			printf("ofxWinMenu::Load\n%s is not an initialization file\n", filename.c_str());
+			return false;
+		}
+	}
+
+	// Add full path if necessary
+	inipath = GetIniPath(filename);
+
+	ofxWinMenuTrace::span span(trace.get(), "Load");
+
+	// Binary state file if it matches the menu and has not been
+	// replaced by a later initialization file
+	if (bBinaryState) {
+		std::string binpath = GetBinaryPath(inipath);
+		if (!IsFileOlder(binpath, inipath) && LoadBinary(binpath))
+			return true;
+	}
+
+	// Check that the file exists in case an extension was added
+	if (_access(inipath.c_str(), 0) == -1) {
+		printf("ofxWinMenu::Load\nInitialization file \"%s\" not found.\n", inipath.c_str());
+		return false;
+	}
+
+	// Read the "Menu" section
+	std::unordered_map<std::string, std::string> keys;
+	if (!ReadIniSection(inipath, "Menu", keys)) {
+		printf("ofxWinMenu::Load\nCould not read \"%s\"\n", inipath.c_str());
+		return false;
+	}
+
+	// Load item states
+	// Only those saved in the ini file are changed
+	std::vector<int> changed;
+	BeginUpdate();
+	for (int i = 0; i < (int)itemNames.size(); i++) {
+		if (itemNames[i].empty()) continue;
+		auto it = keys.find(IniLower(itemNames[i]));
+		if (it != keys.end() && !it->second.empty()) {
+			if (isChecked[i] != (atoi(it->second.c_str()) == 1)) {
+				SetPopupItem(i, !isChecked[i]);
+				changed.push_back(i);
+			}
+		}
+	}
+	// Radio groups saved with the name of the selected item
+	for (int g = 0; g < (int)radioGroups.size(); g++) {
+		auto it = keys.find(IniLower(radioGroups[g].name));
+		if (it == keys.end()) continue;
+		// Look for the name in this group only, because different groups
+		// can have items of the same name, such as "None"
+		int item = -1;
+		auto range = itemIndex.equal_range(it->second);
+		for (auto named = range.first; named != range.second; ++named) {
+			if (itemGroups[named->second] == g && (item < 0 || named->second < item))
+				item = named->second;
+		}
+		if (item >= 0 && item != radioGroups[g].selected) {
+			SetPopupItem(item, true);
+			changed.push_back(item);
+		}
+	}
+	EndUpdate();
+
+	// Return new values to ofApp
+	for (int i : changed)
+		ItemFunction(i);
+
+	return true;
+}
+
+//
+// Initialization file
+//
+
+// Initialization file name with ".ini" extension
+std::string ofxWinMenu::GetIniName(std::string filename)
+{
+	size_t pos = filename.rfind(".ini");
+	if (pos == std::string::npos) {
+		// No extension or not ".ini"
+		pos = filename.rfind(".");
+		if (pos == std::string::npos) {
+			// No extension - add ".ini"
+			filename = filename + ".ini";
+		}
+		else {
+			// Extension not "ini" 
+			// Strip extension
+			filename = filename.substr(0, pos);
+			// Add ".ini"
+			filename = filename + ".ini";
+		}
+	}
+	return filename;
+}
+
+// Full path of an initialization file
+std::string ofxWinMenu::GetIniPath(const std::string &filename)
+{
+	// Check for full path
+	if (filename.find('/') != std::string::npos || filename.find('\\') != std::string::npos)
+		return filename;
+
+	// filename only - add full path - (bin\data directory)
+	char path[MAX_PATH]{};
+	GetModuleFileNameA(NULL, path, MAX_PATH);
+	PathRemoveFileSpecA(path);
+	std::string inipath = path;
+	return inipath + "\\data\\" + filename;
+}
+
+//
+// Replace the keys of one section of initialization file text
+//
+// Keys that exist in the section are given the new value in place and new keys
+// are added at the end of the section. The section is added at the end if it
+// does not exist. Other sections and keys are not changed. Section and key
+// names are not case sensitive, the same as WritePrivateProfileString.
+//
+std::string ofxWinMenu::MergeIniSection(const std::string &text, const std::string &section,
+	const std::vector<std::pair<std::string, std::string>> &keys)
+{
+	// Key number from the key name
+	std::unordered_map<std::string, size_t> keyIndex;
+	keyIndex.reserve(keys.size());
+	for (size_t i = 0; i < keys.size(); i++)
+		keyIndex.emplace(IniLower(keys[i].first), i);
+	std::vector<bool> bWritten(keys.size(), false);
+
+	std::string output;
+	output.reserve(text.size() + keys.size() * 16 + section.size() + 4);
+
+	bool bInSection = false;
+	bool bFound = false;
+	std::string blankLines; // Blank lines at the end of the section
+
+	// Add the keys not already in the section
+	auto addKeys = [&]() {
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (!bWritten[i]) {
+				output += keys[i].first + "=" + keys[i].second + "\r\n";
+				bWritten[i] = true;
+			}
+		}
+	};
+
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) end = text.size();
+		std::string line = text.substr(start, end - start);
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		start = end + 1;
+
+		std::string trimmed = IniTrim(line);
+
+		// Section name
+		if (!trimmed.empty() && trimmed[0] == '[') {
+			if (bInSection) {
+				addKeys();
+				output += blankLines;
+				blankLines.clear();
+			}
+			size_t close = trimmed.find(']');
+			std::string name = IniTrim(trimmed.substr(1, close == std::string::npos ? std::string::npos : close - 1));
+			bInSection = !bFound && IniNameEqual(name, section);
+			if (bInSection) bFound = true;
+			output += line + "\r\n";
+			continue;
+		}
+
+		if (bInSection) {
+			// Keep blank lines after the last key
+			if (trimmed.empty()) {
+				blankLines += "\r\n";
+				continue;
+			}
+			output += blankLines;
+			blankLines.clear();
+			// Replace the value of an existing key
+			size_t equal = trimmed.find('=');
+			if (equal != std::string::npos && trimmed[0] != ';') {
+				auto it = keyIndex.find(IniLower(IniTrim(trimmed.substr(0, equal))));
+				if (it != keyIndex.end() && !bWritten[it->second]) {
+					output += keys[it->second].first + "=" + keys[it->second].second + "\r\n";
+					bWritten[it->second] = true;
+					continue;
+				}
+			}
+		}
+		output += line + "\r\n";
+	}
+
+	// The section is the last in the file or does not exist
+	if (!bFound)
+		output += "[" + section + "]\r\n";
+	addKeys();
+	output += blankLines;
+
+	return output;
+}
+
+//
+// Read the keys of one section of initialization file text
+//
+// Key names are converted to lower case because they are not case sensitive.
+// The first key of a name is used, the same as GetPrivateProfileString.
+//
+void ofxWinMenu::ParseIniSection(const std::string &text, const std::string &section,
+	std::unordered_map<std::string, std::string> &keys)
+{
+	bool bInSection = false;
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) end = text.size();
+		std::string line = IniTrim(text.substr(start, end - start));
+		start = end + 1;
+
+		if (line.empty() || line[0] == ';')
+			continue;
+
+		// Section name
+		if (line[0] == '[') {
+			size_t close = line.find(']');
+			bInSection = IniNameEqual(IniTrim(line.substr(1, close == std::string::npos ? std::string::npos : close - 1)), section);
+			continue;
+		}
+
+		if (bInSection) {
+			size_t equal = line.find('=');
+			if (equal != std::string::npos)
+				keys.emplace(IniLower(IniTrim(line.substr(0, equal))), IniTrim(line.substr(equal + 1)));
+		}
+	}
+}
+
+// Read the keys of one section of an initialization file in one pass
+bool ofxWinMenu::ReadIniSection(const std::string &inipath, const std::string &section,
+	std::unordered_map<std::string, std::string> &keys)
+{
+	std::ifstream infile(inipath, std::ios::binary);
+	if (!infile.is_open())
+		return false;
+	std::string text((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+	ParseIniSection(text, section, keys);
+	return true;
+}
+
+//
+// Write one section of an initialization file
+//
+// The file is read and the new file written in one pass. It is written
+// to a temporary file first, which then replaces the original, so the
+// original is not damaged if writing fails.
+//
+bool ofxWinMenu::WriteIniSection(const std::string &inipath, const std::string &section,
+	const std::vector<std::pair<std::string, std::string>> &keys)
+{
+	// One file is written at a time, so that changes
+	// by different threads to the same file are not lost
+	static std::mutex writeMutex;
+	std::lock_guard<std::mutex> lock(writeMutex);
+
+	// Existing file if any
+	std::string text;
+	std::ifstream infile(inipath, std::ios::binary);
+	if (infile.is_open()) {
+		text.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+		infile.close();
+	}
+
+	std::string output = MergeIniSection(text, section, keys);
+
+	std::string tmppath = inipath + ".tmp";
+	std::ofstream outfile(tmppath, std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open())
+		return false;
+	outfile.write(output.data(), (std::streamsize)output.size());
+	outfile.close();
+	if (outfile.fail()) {
+		DeleteFileA(tmppath.c_str());
+		return false;
+	}
+
+	if (!MoveFileExA(tmppath.c_str(), inipath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		DeleteFileA(tmppath.c_str());
+		return false;
+	}
+	return true;
+}
+
+//
+// Auto save
+//
+// Items that are changed are saved to an initialization file
+// by a separate thread when there have been no more changes for
+// a quiet period. Only the changed items are written and other
+// items and sections of the file are not changed. Many changes
+// in a short time result in only one write.
+//
+// Changes not yet saved are saved by StopAutoSave and when
+// ofxWinMenu is deleted.
+//
+//     filename  - initialization file, the same as for Save
+//     quietms   - milliseconds after the last change before saving
+//
+void ofxWinMenu::SetAutoSave(std::string filename, int quietms)
+{
+	StopAutoSave();
+	if (quietms <= 0)
+		return;
+
+	autoSavePath = GetIniPath(GetIniName(filename));
+	autoSaveBinaryPath = GetBinaryPath(autoSavePath);
+	autoSaveQuiet = std::chrono::milliseconds(quietms);
+
+	// Names of the auto check and radio items, which are saved
+	autoSaveNames.clear();
+	autoSaveGroups.clear();
+	for (int i = 0; i < (int)itemNames.size(); i++)
+		SetAutoSaveName(i);
+
+	bAutoSaveQuit = false;
+	bAutoSavePending = false;
+	bAutoSave = true;
+	autoSaveThread = std::thread(&ofxWinMenu::AutoSaveThread, this);
+}
+
+// Stop auto save and save changes not yet saved
+void ofxWinMenu::StopAutoSave()
+{
+	if (!bAutoSave)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(autoSaveMutex);
+		bAutoSaveQuit = true;
+	}
+	autoSaveCondition.notify_one();
+	if (autoSaveThread.joinable())
+		autoSaveThread.join();
+	bAutoSave = false;
+}
+
+// Number of auto save file writes
+int ofxWinMenu::GetAutoSaveWrites()
+{
+	return nAutoSaveWrites;
+}
+
+// Number of changes saved by the same write as another change
+int ofxWinMenu::GetAutoSaveCoalesced()
+{
+	int nCoalesced = nAutoSaveChanges - nAutoSaveWrites;
+	return (nCoalesced > 0 ? nCoalesced : 0);
+}
+
+// Record a changed item to be saved
+void ofxWinMenu::SetItemDirty(int item)
+{
+	isDirty.set(item, true);
+	if (bAutoSave) {
+		{
+			std::lock_guard<std::mutex> lock(autoSaveMutex);
+			autoSaveTime = std::chrono::steady_clock::now();
+			bAutoSavePending = true;
+		}
+		nAutoSaveChanges++;
+		autoSaveCondition.notify_one();
+	}
+}
+
+// Changed items to save, called with the auto save lock
+void ofxWinMenu::GetDirtyKeys(std::vector<std::pair<std::string, std::string>> &keys)
+{
+	// Take the changed flags before the checked flags. If an item
+	// is changed again after this, it is saved by the next write.
+	int nWords = isDirty.words();
+	std::vector<uint64_t> dirty(nWords);
+	for (int i = 0; i < nWords; i++)
+		dirty[i] = isDirty.take(i);
+
+	std::vector<uint64_t> checked, enabled;
+	Snapshot(checked, enabled);
+
+	for (int i = 0; i < nWords && i < (int)checked.size(); i++) {
+		for (uint64_t bits = dirty[i]; bits != 0; bits &= bits - 1) {
+			int bit = 0;
+			while (!((bits >> bit) & 1)) bit++;
+			int item = i * 64 + bit;
+			if (item >= (int)autoSaveNames.size() || autoSaveNames[item].empty())
+				continue;
+			bool bChecked = ((checked[i] >> bit) & 1) != 0;
+			if (autoSaveGroups[item].empty())
+				keys.emplace_back(autoSaveNames[item], bChecked ? "1" : "0");
+			else if (bChecked) // The item selected in a radio group
+				keys.emplace_back(autoSaveGroups[item], autoSaveNames[item]);
+		}
+	}
+}
+
+// Auto save thread
+void ofxWinMenu::AutoSaveThread()
+{
+	std::unique_lock<std::mutex> lock(autoSaveMutex);
+	while (!bAutoSaveQuit) {
+		if (!bAutoSavePending) {
+			autoSaveCondition.wait(lock);
+			continue;
+		}
+		// Wait for the quiet period after the last change
+		auto due = autoSaveTime + autoSaveQuiet;
+		if (std::chrono::steady_clock::now() < due) {
+			autoSaveCondition.wait_until(lock, due);
+			continue;
+		}
+		bAutoSavePending = false;
+		std::vector<std::pair<std::string, std::string>> keys;
+		GetDirtyKeys(keys);
+		lock.unlock();
+		if (!keys.empty()) {
+			ofxWinMenuTrace::span span(trace.get(), "AutoSave");
+			AutoSaveWrite(keys);
+		}
+		lock.lock();
+	}
+
+	// Save changes not yet saved
+	std::vector<std::pair<std::string, std::string>> keys;
+	GetDirtyKeys(keys);
+	lock.unlock();
+	if (!keys.empty())
+		AutoSaveWrite(keys);
+}
+
+// Write the changed items to the initialization file
+// The binary state file would no longer match it and is deleted first,
+// so that Load cannot restore the states from before the changes.
+// Save writes the binary file again.
+void ofxWinMenu::AutoSaveWrite(const std::vector<std::pair<std::string, std::string>> &keys)
+{
+	DeleteFileA(autoSaveBinaryPath.c_str());
+	WriteIniSection(autoSavePath, "Menu", keys);
+	nAutoSaveWrites++;
+}
+
+//
+// Binary state file
+//
+// The item states are saved in a binary file with the same name as
+// the initialization file and extension ".menu". The file is read
+// by mapping it to memory without parsing text, which is faster than
+// an initialization file for a large menu.
+//
+// The initialization file is still saved and is loaded instead if the
+// binary file does not exist or does not match the menu items.
+//
+// File layout
+//
+//     header         - identifier, version, item count and checksum
+//     uint64_t hash  - name hash of each item, 0 for a separator
+//     uint64_t words - checked flags, 64 items for each word
+//     uint64_t words - enabled flags, 64 items for each word
+//
+// The checksum is of all data following the header.
+//
+
+// Binary file header
+struct binaryHeader {
+	char id[4];          // "OXWM"
+	uint32_t version;    // binaryVersion
+	uint32_t nItems;     // Number of items
+	uint32_t checksum;   // Checksum of the data following the header
+};
+static const uint32_t binaryVersion = 1;
+
+// 64 bit FNV-1a hash of an item name
+static uint64_t NameHash(const std::string &name)
+{
+	if (name.empty()) return 0;
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : name) {
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// 32 bit FNV-1a checksum of the file data
+static uint32_t DataChecksum(const unsigned char *data, size_t size)
+{
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+// Save and load a binary copy of the item states
+// With bBinaryOnly, Save writes the binary file instead of the initialization file
+void ofxWinMenu::SetBinaryState(bool bBinary, bool bBinaryOnly)
+{
+	bBinaryState = bBinary;
+	this->bBinaryOnly = bBinary && bBinaryOnly;
+}
+
+// The file written by Save, the binary file if it is saved alone
+std::string ofxWinMenu::GetSavePath(const std::string &inipath)
+{
+	return bBinaryOnly ? GetBinaryPath(inipath) : inipath;
+}
+
+// Binary state file path from the initialization file path
+std::string ofxWinMenu::GetBinaryPath(const std::string &inipath)
+{
+	size_t pos = inipath.rfind('.');
+	if (pos == std::string::npos || inipath.find_first_of("/\\", pos) != std::string::npos)
+		return inipath + ".menu";
+	return inipath.substr(0, pos) + ".menu";
+}
+
+// Save the item states to a binary file
+bool ofxWinMenu::SaveBinary(const std::string &binpath)
+{
+	std::vector<uint64_t> data;
+	uint32_t nItems = GetBinaryData(data);
+	return WriteBinary(binpath, nItems, data);
+}
+
+// Binary file data following the header, returns the number of items
+uint32_t ofxWinMenu::GetBinaryData(std::vector<uint64_t> &data)
+{
+	int nItems = (int)itemNames.size();
+	int nWords = (nItems + 63) / 64;
+
+	data.clear();
+	data.reserve(nItems + nWords * 2);
+	for (int i = 0; i < nItems; i++)
+		data.push_back(NameHash(itemNames[i]));
+	std::vector<uint64_t> checked, enabled;
+	Snapshot(checked, enabled);
+	data.insert(data.end(), checked.begin(), checked.end());
+	data.insert(data.end(), enabled.begin(), enabled.end());
+
+	return (uint32_t)nItems;
+}
+
+// Write a binary file
+bool ofxWinMenu::WriteBinary(const std::string &binpath, uint32_t nItems, const std::vector<uint64_t> &data)
+{
+	// One file is written at a time
+	static std::mutex writeMutex;
+	std::lock_guard<std::mutex> lock(writeMutex);
+
+	binaryHeader header{ { 'O', 'X', 'W', 'M' }, binaryVersion, nItems, 0 };
+	header.checksum = DataChecksum((const unsigned char *)data.data(), data.size() * sizeof(uint64_t));
+
+	// Write to a temporary file and replace the original
+	std::string tmppath = binpath + ".tmp";
+	std::ofstream outfile(tmppath, std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open())
+		return false;
+	outfile.write((const char *)&header, sizeof(header));
+	outfile.write((const char *)data.data(), (std::streamsize)(data.size() * sizeof(uint64_t)));
+	outfile.close();
+	if (outfile.fail() || !MoveFileExA(tmppath.c_str(), binpath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		DeleteFileA(tmppath.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Load the item states from a binary file
+// Returns false if the file does not exist or does not match the menu items
+bool ofxWinMenu::LoadBinary(const std::string &binpath)
+{
+	HANDLE hFile = CreateFileA(binpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size{};
+	HANDLE hMap = NULL;
+	const unsigned char *view = nullptr;
+	if (GetFileSizeEx(hFile, &size) && size.QuadPart >= (long long)sizeof(binaryHeader)) {
+		hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap)
+			view = (const unsigned char *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	}
+
+	bool bLoaded = false;
+	if (view) {
+		binaryHeader header{};
+		memcpy(&header, view, sizeof(header));
+		size_t nItems = itemNames.size();
+		size_t nWords = (nItems + 63) / 64;
+		size_t nData = (nItems + nWords * 2) * sizeof(uint64_t);
+		const uint64_t *data = (const uint64_t *)(view + sizeof(binaryHeader));
+		if (memcmp(header.id, "OXWM", 4) == 0
+			&& header.version == binaryVersion
+			&& header.nItems == nItems
+			&& (size_t)size.QuadPart == sizeof(binaryHeader) + nData
+			&& header.checksum == DataChecksum(view + sizeof(binaryHeader), nData)) {
+			// The item names must match
+			bLoaded = true;
+			for (size_t i = 0; i < nItems && bLoaded; i++)
+				bLoaded = (data[i] == NameHash(itemNames[i]));
+		}
+		// Enabled states are in the file but are not restored,
+		// the same as for the initialization file
+		if (bLoaded) {
+			const uint64_t *checked = data + nItems;
+			std::vector<int> changed;
+			BeginUpdate();
+			for (int i = 0; i < (int)nItems; i++) {
+				// Checked states are saved for auto check items, the same as Save
+				bool bChecked = ((checked[i / 64] >> (i % 64)) & 1) != 0;
+				if (autoCheck[i] && isChecked[i] != bChecked) {
+					SetPopupItem(i, bChecked);
+					changed.push_back(i);
+				}
+				// The selected radio item
+				if (itemGroups[i] >= 0 && bChecked && !isChecked[i]) {
+					SetPopupItem(i, true);
+					changed.push_back(i);
+				}
+			}
+			EndUpdate();
+
+			// Return new values to ofApp
+			for (int i : changed)
+				ItemFunction(i);
+		}
+		UnmapViewOfFile(view);
+	}
+	if (hMap) CloseHandle(hMap);
+	CloseHandle(hFile);
+
+	return bLoaded;
+}
+
+//
+// Item table
+//
+
+// Add an item to the table and return the item number, -1 if there are no more.
+// The item number is the command ID of the menu item.
+// The item is placed at the position in the submenu, or at the end if -1.
+int ofxWinMenu::AddItem(HMENU hSubMenu, int position, const std::string &ItemName, bool bChecked, bool bAutoCheck)
+{
+	int item = -1;
+	if(!freeItems.empty()) {
+		// Use the lowest item number of a removed item
+		std::pop_heap(freeItems.begin(), freeItems.end(), std::greater<int>());
+		item = freeItems.back();
+		freeItems.pop_back();
+		subMenus[item] = hSubMenu;
+		itemNames[item] = ItemName;
+		BeginFlagChange();
+		isChecked.set(item, bChecked);
+		isEnabled.set(item, true);
+		EndFlagChange();
+		isDirty.set(item, false);
+		autoCheck[item] = bAutoCheck;
+		itemFunctions[item] = nullptr;
+		menuChecked[item] = false;
+		menuEnabled[item] = true;
+		itemGroups[item] = -1;
+		itemKeys[item] = 0;
+	}
+	else {
+		// Item numbers are command IDs below those of lazy menu items
+		if((int)itemNames.size() >= lazyFirstID) {
+			printf("ofxWinMenu::AddItem\nNo more than %d items can be added\n", lazyFirstID);
+			return -1;
+		}
+		item = (int)itemNames.size();
+		itemNodes.push_back(-1);
+		subMenus.push_back(hSubMenu);
+		itemNames.push_back(ItemName);
+		BeginFlagChange();
+		isChecked.push_back(bChecked);
+		isEnabled.push_back(true);
+		EndFlagChange();
+		isDirty.push_back(false);
+		autoCheck.push_back(bAutoCheck);
+		itemFunctions.push_back(nullptr);
+		menuChecked.push_back(false);
+		menuEnabled.push_back(true);
+		isPending.push_back(false);
+		itemGroups.push_back(-1);
+		itemKeys.push_back(0);
+	}
+	itemNodes[item] = NewOrderNode(hSubMenu, item);
+	OrderInsert(itemNodes[item], position);
+	// Items are found by name
+	if(!ItemName.empty())
+		itemIndex.emplace(ItemName, item);
+	// Auto save has a copy of the names of auto check items
+	if(bAutoSave)
+		SetAutoSaveName(item);
+	return item;
+}
+
+// Remove an item from the table
+// The item number is kept for the next item added
+void ofxWinMenu::RemoveItem(int item)
+{
+	OrderRemove(itemNodes[item]);
+	itemNodes[item] = -1;
+	if(!itemMirrors.empty()) {
+		auto range = itemMirrors.equal_range(item);
+		for(auto it = range.first; it != range.second; ++it)
+			OrderRemove(it->second.second);
+		itemMirrors.erase(item);
+	}
+	auto range = itemIndex.equal_range(itemNames[item]);
+	for(auto it = range.first; it != range.second; ++it) {
+		if(it->second == item) {
+			itemIndex.erase(it);
+			break;
+		}
+	}
+	subMenus[item] = NULL;
+	itemNames[item].clear();
+	BeginFlagChange();
+	isChecked.set(item, false);
+	isEnabled.set(item, false);
+	EndFlagChange();
+	autoCheck[item] = false;
+	itemFunctions[item] = nullptr;
+	menuChecked[item] = false;
+	menuEnabled[item] = false;
+	if(itemGroups[item] >= 0 && radioGroups[itemGroups[item]].selected == item)
+		radioGroups[itemGroups[item]].selected = -1;
+	itemGroups[item] = -1;
+	if(itemKeys[item] != 0) {
+		keyIndex.erase(itemKeys[item]);
+		itemKeys[item] = 0;
+	}
+	if(bAutoSave)
+		SetAutoSaveName(item);
+	freeItems.push_back(item);
+	std::push_heap(freeItems.begin(), freeItems.end(), std::greater<int>());
+}
+
+// Copy the names of an item for auto save
+// Auto check items are saved by name and radio items by the group name
+void ofxWinMenu::SetAutoSaveName(int item)
+{
+	std::lock_guard<std::mutex> lock(autoSaveMutex);
+	if(item >= (int)autoSaveNames.size()) {
+		autoSaveNames.resize(item + 1);
+		autoSaveGroups.resize(item + 1);
+	}
+	bool bRadio = (itemGroups[item] >= 0);
+	autoSaveNames[item] = (autoCheck[item] || bRadio) ? itemNames[item] : "";
+	autoSaveGroups[item] = bRadio ? radioGroups[itemGroups[item]].name : "";
+}
+
+// Reserve space for a number of items
+void ofxWinMenu::ReserveItems(int nItems)
+{
+	itemNodes.reserve(nItems);
+	orderNodes.reserve(nItems);
+	itemGroups.reserve(nItems);
+	itemKeys.reserve(nItems);
+	subMenus.reserve(nItems);
+	itemNames.reserve(nItems);
+	autoCheck.reserve(nItems);
+	itemFunctions.reserve(nItems);
+	menuChecked.reserve(nItems);
+	menuEnabled.reserve(nItems);
+	isPending.reserve(nItems);
+	itemIndex.reserve(nItems);
+}
+
+// Set the checked state of an item
+bool ofxWinMenu::SetItemChecked(int item, bool bChecked)
+{
+	if(item < 0 || item >= isChecked.size() || isChecked[item] == bChecked)
+		return false;
+	BeginFlagChange();
+	isChecked.set(item, bChecked);
+	EndFlagChange();
+	SetItemDirty(item);
+	return true;
+}
+
+// Set the enabled state of an item
+bool ofxWinMenu::SetItemEnabled(int item, bool bEnabled)
+{
+	if(item < 0 || item >= isEnabled.size() || isEnabled[item] == bEnabled)
+		return false;
+	BeginFlagChange();
+	isEnabled.set(item, bEnabled);
+	EndFlagChange();
+	return true;
+}
+
+// Record an item changed during an update
+void ofxWinMenu::SetItemPending(int item)
+{
+	nUpdateCalls++;
+	if(!isPending[item]) {
+		isPending[item] = true;
+		updateItems.push_back(item);
+	}
+}
+
+//
+// Submenu order
+//
+// The entries of each submenu are the nodes of a treap, a binary tree
+// ordered by position and balanced by a random priority for each node.
+// The position of a node is the number of nodes before it in the tree.
+//
+
+// New node for an entry of a submenu, not yet in the tree
+int ofxWinMenu::NewOrderNode(HMENU hMenu, int item)
+{
+	// xorshift
+	orderRandom ^= orderRandom << 13;
+	orderRandom ^= orderRandom >> 17;
+	orderRandom ^= orderRandom << 5;
+	orderNode node{ -1, -1, -1, 1, orderRandom, item, hMenu };
+	if(!freeNodes.empty()) {
+		int n = freeNodes.back();
+		freeNodes.pop_back();
+		orderNodes[n] = node;
+		return n;
+	}
+	orderNodes.push_back(node);
+	return (int)orderNodes.size() - 1;
+}
+
+// Number of nodes in a subtree
+int ofxWinMenu::OrderSize(int node)
+{
+	return (node < 0) ? 0 : orderNodes[node].size;
+}
+
+// Size and child links of a node after its children have changed
+void ofxWinMenu::OrderUpdate(int node)
+{
+	orderNode &n = orderNodes[node];
+	n.size = 1 + OrderSize(n.left) + OrderSize(n.right);
+	if(n.left >= 0) orderNodes[n.left].parent = node;
+	if(n.right >= 0) orderNodes[n.right].parent = node;
+}
+
+// Join two trees, all nodes of "a" before those of "b"
+int ofxWinMenu::OrderMerge(int a, int b)
+{
+	if(a < 0) return b;
+	if(b < 0) return a;
+	if(orderNodes[a].priority > orderNodes[b].priority) {
+		orderNodes[a].right = OrderMerge(orderNodes[a].right, b);
+		OrderUpdate(a);
+		return a;
+	}
+	orderNodes[b].left = OrderMerge(a, orderNodes[b].left);
+	OrderUpdate(b);
+	return b;
+}
+
+// Split a tree into the first "count" nodes and the rest
+void ofxWinMenu::OrderSplit(int node, int count, int &a, int &b)
+{
+	if(node < 0) {
+		a = b = -1;
+		return;
+	}
+	int nLeft = OrderSize(orderNodes[node].left);
+	if(count <= nLeft) {
+		OrderSplit(orderNodes[node].left, count, a, orderNodes[node].left);
+		OrderUpdate(node);
+		b = node;
+	}
+	else {
+		OrderSplit(orderNodes[node].right, count - nLeft - 1, orderNodes[node].right, b);
+		OrderUpdate(node);
+		a = node;
+	}
+}
+
+// Insert a node at a position of its submenu, or at the end if -1
+void ofxWinMenu::OrderInsert(int node, int position)
+{
+	auto it = orderRoots.find(orderNodes[node].hMenu);
+	int root = (it == orderRoots.end()) ? -1 : it->second;
+	if(position < 0 || position >= OrderSize(root)) {
+		// Add at the end without splitting the tree
+		root = OrderMerge(root, node);
+	}
+	else {
+		int a = -1, b = -1;
+		OrderSplit(root, position, a, b);
+		root = OrderMerge(OrderMerge(a, node), b);
+	}
+	orderNodes[root].parent = -1;
+	orderRoots[orderNodes[node].hMenu] = root;
+}
+
+// Remove a node from its submenu
+void ofxWinMenu::OrderRemove(int node)
+{
+	if(node < 0) return;
+	orderNode &n = orderNodes[node];
+	int child = OrderMerge(n.left, n.right);
+	int parent = n.parent;
+	if(child >= 0)
+		orderNodes[child].parent = parent;
+	if(parent < 0) {
+		orderRoots[n.hMenu] = child;
+	}
+	else {
+		if(orderNodes[parent].left == node)
+			orderNodes[parent].left = child;
+		else
+			orderNodes[parent].right = child;
+		// Sizes of the nodes above
+		for(int p = parent; p >= 0; p = orderNodes[p].parent)
+			orderNodes[p].size--;
+	}
+	n.left = n.right = n.parent = -1;
+	n.item = -1;
+	freeNodes.push_back(node);
+}
+
+// Position of a node in its submenu
+int ofxWinMenu::OrderPosition(int node)
+{
+	int position = OrderSize(orderNodes[node].left);
+	for(int p = orderNodes[node].parent; p >= 0; node = p, p = orderNodes[p].parent) {
+		if(orderNodes[p].right == node)
+			position += OrderSize(orderNodes[p].left) + 1;
+	}
+	return position;
+}
+
+// Number of entries in a submenu
+int ofxWinMenu::OrderCount(HMENU hMenu)
+{
+	auto it = orderRoots.find(hMenu);
+	return (it == orderRoots.end()) ? 0 : OrderSize(it->second);
+}
+
+// Item flags are changed by one thread between these functions.
+// The sequence number is odd while the flags are changed.
+void ofxWinMenu::BeginFlagChange()
+{
+	flagSequence.store(flagSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ofxWinMenu::EndFlagChange()
+{
+	flagSequence.store(flagSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//
+// Windows menu functions
+//
+
+// The menu exists and can be changed
+bool ofxWinMenu::IsMenuValid()
+{
+	return (g_hwnd && g_hMenu && backend->IsMenuHandle(g_hMenu));
+}
+
+// Insert an item or separator at the position recorded for it
+bool ofxWinMenu::MenuInsertItem(int item)
+{
+	if(!IsItem(item))
+		return false;
+	int position = OrderPosition(itemNodes[item]);
+	if(itemNames[item].empty())
+		return backend->InsertItem(subMenus[item], position, MF_BYPOSITION | MF_SEPARATOR, item, NULL);
+	if(!backend->InsertItem(subMenus[item], position, MF_BYPOSITION, item, GetItemText(item).c_str()))
+		return false;
+	// Radio items are checked with a bullet
+	if(itemGroups[item] >= 0)
+		backend->SetItemRadio(subMenus[item], position, MF_BYPOSITION);
+	return true;
+}
+
+// Delete an item or separator from its submenu and context menus
+bool ofxWinMenu::MenuRemoveItem(int item)
+{
+	if(!itemMirrors.empty()) {
+		auto range = itemMirrors.equal_range(item);
+		for(auto it = range.first; it != range.second; ++it)
+			backend->DeleteItem(it->second.first, OrderPosition(it->second.second), MF_BYPOSITION);
+	}
+	return backend->DeleteItem(subMenus[item], OrderPosition(itemNodes[item]), MF_BYPOSITION);
+}
+
+// Insert an item in a context menu at the position of an order node
+// The item is shown with the state shown by the window menu
+bool ofxWinMenu::MenuInsertMirror(int item, HMENU hMenu, int node)
+{
+	int position = OrderPosition(node);
+	UINT flags = MF_BYPOSITION;
+	if(menuChecked[item]) flags |= MF_CHECKED;
+	if(!menuEnabled[item]) flags |= MF_DISABLED;
+	if(!backend->InsertItem(hMenu, position, flags, item, GetItemText(item).c_str()))
+		return false;
+	if(itemGroups[item] >= 0)
+		backend->SetItemRadio(hMenu, position, MF_BYPOSITION);
+	return true;
+}
+
+// Show the checked state of an item
+// The position of the item in the submenu is found from the submenu order
+void ofxWinMenu::MenuCheckItem(int item)
+{
+	int position = OrderPosition(itemNodes[item]);
+	menuChecked[item] = isChecked[item];
+	UINT check = isChecked[item] ? MF_CHECKED : MF_UNCHECKED;
+	backend->CheckItem(subMenus[item], position, MF_BYPOSITION | check);
+
+	// The same item in context menus
+	if(!itemMirrors.empty()) {
+		auto range = itemMirrors.equal_range(item);
+		for(auto it = range.first; it != range.second; ++it)
+			backend->CheckItem(it->second.first, item, MF_BYCOMMAND | check);
+	}
+}
+
+// Show the enabled state of an item
+void ofxWinMenu::MenuEnableItem(int item)
+{
+	menuEnabled[item] = isEnabled[item];
+	UINT enable = isEnabled[item] ? MF_ENABLED : MF_DISABLED;
+	backend->EnableItem(subMenus[item], item, MF_BYCOMMAND | enable);
+
+	// The same item in context menus
+	if(!itemMirrors.empty()) {
+		auto range = itemMirrors.equal_range(item);
+		for(auto it = range.first; it != range.second; ++it)
+			backend->EnableItem(it->second.first, item, MF_BYCOMMAND | enable);
+	}
+}
+
+//
+// Selection of a menu item
+//
+// The item is checked or unchecked if auto check is enabled for it
+// and the new state is returned to ofApp. Returns false if the
+// command ID is not a menu item.
+//
+bool ofxWinMenu::MenuCommand(int id)
+{
+	ofxWinMenuTrace::span span(trace.get(), "Command", id);
+
+#ifdef OFXWINMENU_METRICS
+	// Time taken by the command, including the ofApp function
+	auto start = std::chrono::steady_clock::now();
+	bool bHandled = DispatchCommand(id);
+	if(bHandled)
+		RecordCommand(id, std::chrono::steady_clock::now() - start);
+	return bHandled;
+#else
+	return DispatchCommand(id);
+#endif
+}
+
+// Select the item of a command ID
+bool ofxWinMenu::DispatchCommand(int id)
+{
+	// Lazy popup menu item
+	if(id >= lazyFirstID)
+		return LazyMenuCommand(id);
+
+	// Only menu items are handled
+	if(!IsItem(id))
+		return false;
+
+	// Select a radio item
+	if(itemGroups[id] >= 0) {
+		SetPopupItem(id, true);
+	}
+	// Check the menu item if autocheck is enabled for it
+	else if(autoCheck[id]) {
+		// toggle the menu item state flag
+		SetItemChecked(id, !isChecked[id]);
+		MenuCheckItem(id);
+	}
+
+	// Inform ofApp of the menu item new state
+	ItemFunction(id);
+
+	return true;
+}
+
+//
+// Trace of menu activity
+//
+// While recording, the menu loop, menu commands, item functions, Save, Load
+// and file writes by other threads are recorded with their start time and
+// duration. The trace is saved as Trace Event JSON, which can be opened by
+// a trace viewer such as "chrome://tracing" or "ui.perfetto.dev".
+// ofApp can add its own events, such as a frame marker in Draw :
+//
+//     menu->StartTrace();
+//     ...
+//     menu->TraceMark("Frame");
+//     ...
+//     menu->StopTrace();
+//     menu->SaveTrace("menutrace.json");
+//
+// The events are recorded in a buffer allocated by StartTrace.
+// When it is full, the oldest events are replaced.
+//
+bool ofxWinMenu::StartTrace(int nEvents)
+{
+	if (nEvents <= 0)
+		return false;
+	traceLoopStart = -1;
+	trace->Start((size_t)nEvents);
+	return true;
+}
+
+void ofxWinMenu::StopTrace()
+{
+	trace->Stop();
+}
+
+// Instant event for ofApp
+void ofxWinMenu::TraceMark(const char *name)
+{
+	if (trace->IsRecording())
+		trace->Record(name, -1, 'i', trace->Now(), 0);
+}
+
+// Text for a JSON string
+static std::string JsonEscape(const std::string &str)
+{
+	std::string text;
+	text.reserve(str.size());
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			text += '\\';
+			text += c;
+		}
+		else if ((unsigned char)c < 0x20) {
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+			text += code;
+		}
+		else {
+			text += c;
+		}
+	}
+	return text;
+}
+
+// Recorded events as Trace Event JSON
+std::string ofxWinMenu::GetTraceJSON()
+{
+	std::vector<ofxWinMenuTrace::event> events;
+	trace->GetEvents(events);
+
+	std::string json = "{\"traceEvents\":[";
+	char line[256];
+	for (size_t i = 0; i < events.size(); i++) {
+		const ofxWinMenuTrace::event &e = events[i];
+
+		// Commands and functions are named by the item
+		std::string name = e.name;
+		const char *category = "app";
+		if (strcmp(e.name, "Command") == 0 || strcmp(e.name, "Function") == 0) {
+			category = (e.name[0] == 'C') ? "command" : "callback";
+			if (IsItem(e.id) && !itemNames[e.id].empty())
+				name += " " + itemNames[e.id];
+		}
+		else if (strcmp(e.name, "Menu loop") == 0) {
+			category = "menu";
+		}
+		else if (strcmp(e.name, "Save") == 0 || strcmp(e.name, "SaveAsync") == 0
+			|| strcmp(e.name, "Load") == 0 || strcmp(e.name, "AutoSave") == 0) {
+			category = "file";
+		}
+
+		json += (i > 0) ? ",\n" : "\n";
+		json += "{\"name\":\"" + JsonEscape(name) + "\",\"cat\":\"" + category + "\"";
+		if (e.phase == 'X')
+			snprintf(line, sizeof(line), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+				(double)e.start / 1000.0, (double)e.duration / 1000.0);
+		else
+			snprintf(line, sizeof(line), ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", (double)e.start / 1000.0);
+		json += line;
+		snprintf(line, sizeof(line), ",\"pid\":1,\"tid\":%u", e.thread);
+		json += line;
+		if (e.id >= 0)
+			json += ",\"args\":{\"id\":" + std::to_string(e.id) + "}";
+		json += "}";
+	}
+	json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	return json;
+}
+
+// Save the trace to a file
+// A file name without a path is in the "bin\data" folder
+bool ofxWinMenu::SaveTrace(std::string filename)
+{
+	std::string path = GetIniPath(filename);
+	std::ofstream outfile(path, std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		printf("ofxWinMenu::SaveTrace\nCould not write \"%s\"\n", path.c_str());
+		return false;
+	}
+	outfile << GetTraceJSON();
+	return !outfile.fail();
+}
+
+//
+// Command metrics
+//
+// With OFXWINMENU_METRICS defined, the number of selections of each
+// command and the time taken are recorded. The time
+// is recorded in buckets of powers of two microseconds, so the percentile
+// returned is the upper limit of the bucket and not more than the maximum.
+// Without OFXWINMENU_METRICS nothing is recorded and the functions return 0.
+//
+// Metrics are recorded by the window thread and should be read by it,
+// for example by ofApp Update or Draw.
+//
+// Number of selections of a command
+int ofxWinMenu::GetCommandCount(int id)
+{
+	auto it = commandMetrics.find(id);
+	if (it != commandMetrics.end())
+		return (int)it->second.count;
+	return 0;
+}
+
+// Time in microseconds within which a fraction of the selections
+// of a command were completed, for example 0.5 or 0.99
+double ofxWinMenu::GetCommandLatency(int id, double fraction)
+{
+	auto it = commandMetrics.find(id);
+	if (it == commandMetrics.end() || it->second.count == 0)
+		return 0.0;
+	const commandMetric &metric = it->second;
+	uint64_t rank = (uint64_t)(fraction * (double)metric.count);
+	if (rank >= metric.count) rank = metric.count - 1;
+	uint64_t total = 0;
+	for (int b = 0; b < metricBuckets; b++) {
+		total += metric.buckets[b];
+		if (total > rank) {
+			// Bucket 0 is less than 1 microsecond, bucket b is less than 2^b
+			double limit = (double)(1ull << b);
+			return (std::min)(limit, metric.maxTime);
+		}
+	}
+	return metric.maxTime;
+}
+
+// Longest time in microseconds for a selection of a command
+double ofxWinMenu::GetCommandMaxLatency(int id)
+{
+	auto it = commandMetrics.find(id);
+	if (it != commandMetrics.end())
+		return it->second.maxTime;
+	return 0.0;
+}
+
+//
+// Metrics as text, one line for each command
+//
+//     id  count  p50 us  p99 us  max us  name
+//
+std::string ofxWinMenu::GetMetricsText()
+{
+	std::string text;
+	if (commandMetrics.empty())
+		return text;
+
+	std::vector<int> ids;
+	ids.reserve(commandMetrics.size());
+	for (const auto &metric : commandMetrics)
+		ids.push_back(metric.first);
+	std::sort(ids.begin(), ids.end());
+
+	char line[512];
+	text = "id\tcount\tp50 us\tp99 us\tmax us\tname\n";
+	for (int id : ids) {
+		std::string name;
+		if (IsItem(id))
+			name = itemNames[id];
+		else if (id >= lazyFirstID)
+			name = "lazy menu " + std::to_string(LazyMenuFromID(id));
+		snprintf(line, sizeof(line), "%d\t%llu\t%.0f\t%.0f\t%.1f\t%s\n", id,
+			(unsigned long long)commandMetrics[id].count,
+			GetCommandLatency(id, 0.5), GetCommandLatency(id, 0.99),
+			GetCommandMaxLatency(id), name.c_str());
+		text += line;
+	}
+	return text;
+}
+
+// Clear the metrics of all commands
+void ofxWinMenu::ResetMetrics()
+{
+	commandMetrics.clear();
+}
+
+// Record the time taken by a command
+void ofxWinMenu::RecordCommand(int id, std::chrono::steady_clock::duration elapsed)
+{
+	double us = std::chrono::duration<double, std::micro>(elapsed).count();
+	commandMetric &metric = commandMetrics[id];
+	metric.count++;
+	if (us > metric.maxTime)
+		metric.maxTime = us;
+	// Bucket of the power of two above the time
+	int b = 0;
+	for (uint64_t t = (uint64_t)us; t > 0 && b < metricBuckets - 1; t >>= 1)
+		b++;
+	metric.buckets[b]++;
+}
+
+// ofApp Function for return of memu item selection
+void ofxWinMenu::CreateMenuFunction(void(ofApp::*function)(std::string title, bool bChecked))
+{
+	pAppMenuFunction = function; // Return function in ofApp
+	pAppMenuViewFunction = NULL;
+}
+
+// ofApp Function receiving a view of the item title.
+// The title is not copied when an item is selected.
+void ofxWinMenu::CreateMenuFunction(void(ofApp::*function)(std::string_view title, bool bChecked))
+{
+	pAppMenuViewFunction = function; // Return function in ofApp
+	pAppMenuFunction = NULL;
+}
+
+// ofApp Function receiving the item number instead of the title.
+// It is used instead of the title function for menu item selection.
+void ofxWinMenu::CreateMenuFunction(void(ofApp::*function)(int item, bool bChecked))
+{
+	pAppItemFunction = function; // Return function in ofApp
+}
+
+// Pass back the menu item title and state to ofApp
+// by calling the function set by "CreateMenuFunction"
+void ofxWinMenu::MenuFunction(const std::string &title, bool bChecked)
+{
+	if(pAppMenuViewFunction)
+		(pApp->*pAppMenuViewFunction)(title, bChecked);
+	else if(pAppMenuFunction)
+		(pApp->*pAppMenuFunction)(title, bChecked); 
+}
+
+//
+// Function called for selection of an item
+//
+// The function is called with the new item state instead of the menu function,
+// so that the item title does not have to be compared.
+// The function can be any function object, such as a lambda :
+//
+//     int item = menu->AddPopupItemID(hPopup, "Show info", true);
+//     menu->SetItemFunction(item, [this](bool bChecked) { bShowInfo = bChecked; });
+//
+// or an ofApp function :
+//
+//     menu->SetItemFunction(item, &ofApp::ShowInfo);
+//
+bool ofxWinMenu::SetItemFunction(int item, std::function<void(bool bChecked)> function)
+{
+	if(item < 0 || item >= (int)itemFunctions.size())
+		return false;
+	itemFunctions[item] = function;
+	return true;
+}
+
+bool ofxWinMenu::SetItemFunction(int item, void(ofApp::*function)(bool bChecked))
+{
+	if(!function)
+		return SetItemFunction(item, nullptr);
+	ofApp *app = pApp;
+	return SetItemFunction(item, [app, function](bool bChecked) { (app->*function)(bChecked); });
+}
+
+// Return the item state to ofApp by the item function
+// if there is one, otherwise by the menu function
+void ofxWinMenu::ItemFunction(int item)
+{
+	ofxWinMenuTrace::span span(trace.get(), "Function", item);
+
+	if(itemFunctions[item])
+		itemFunctions[item](isChecked[item]);
+	else if(pAppItemFunction)
+		(pApp->*pAppItemFunction)(item, isChecked[item]);
+	else
+		MenuFunction(itemNames[item], isChecked[item]);
+}
+
+
+//
+// Item flags
+//
+
+ofxWinMenuFlags::ofxWinMenuFlags()
+{
+	for(int i = 0; i < maxBlocks; i++)
+		blocks[i] = nullptr;
+	count = 0;
+}
+
+ofxWinMenuFlags::~ofxWinMenuFlags()
+{
+	clear();
+}
+
+// Add a flag, allocating a new block if necessary
+void ofxWinMenuFlags::push_back(bool bFlag)
+{
+	int n = count.load(std::memory_order_relaxed);
+	int block = n / (blockWords * 64);
+	if(block >= maxBlocks)
+		return;
+	if(!blocks[block].load(std::memory_order_relaxed)) {
+		std::atomic<uint64_t> *words = new std::atomic<uint64_t>[blockWords];
+		for(int i = 0; i < blockWords; i++)
+			words[i].store(0, std::memory_order_relaxed);
+		blocks[block].store(words, std::memory_order_release);
+	}
+	set(n, bFlag);
+	count.store(n + 1, std::memory_order_release);
+}
+
+// Set or clear the flag of an item
+void ofxWinMenuFlags::set(int item, bool bFlag)
+{
+	std::atomic<uint64_t> *words = blocks[item / (blockWords * 64)].load(std::memory_order_acquire);
+	std::atomic<uint64_t> &w = words[(item / 64) % blockWords];
+	uint64_t bit = (uint64_t)1 << (item % 64);
+	if(bFlag)
+		w.fetch_or(bit, std::memory_order_relaxed);
+	else
+		w.fetch_and(~bit, std::memory_order_relaxed);
+}
+
+// Word containing 64 flags, which are cleared
+uint64_t ofxWinMenuFlags::take(int i)
+{
+	std::atomic<uint64_t> *words = blocks[i / blockWords].load(std::memory_order_acquire);
+	if(!words) return 0;
+	return words[i % blockWords].exchange(0, std::memory_order_relaxed);
+}
+
+// Flag of an item
+bool ofxWinMenuFlags::operator[](int item) const
+{
+	return ((word(item / 64) >> (item % 64)) & 1) != 0;
+}
+
+// Number of flags
+int ofxWinMenuFlags::size() const
+{
+	return count.load(std::memory_order_acquire);
+}
+
+// Remove all flags
+// Must not be used while other threads read the flags
+void ofxWinMenuFlags::clear()
+{
+	count = 0;
+	for(int i = 0; i < maxBlocks; i++)
+		delete[] blocks[i].exchange(nullptr);
+}
+
+// Number of words used by the flags
+int ofxWinMenuFlags::words() const
+{
+	return (size() + 63) / 64;
+}
+
+// Word containing 64 flags
+uint64_t ofxWinMenuFlags::word(int i) const
+{
+	std::atomic<uint64_t> *words = blocks[i / blockWords].load(std::memory_order_acquire);
+	if(!words) return 0;
+	return words[i % blockWords].load(std::memory_order_relaxed);
+}
+
+
+//
+// Trace recorder
+//
+
+ofxWinMenuTrace::ofxWinMenuTrace()
+{
+	bRecording = false;
+	nRecorded = 0;
+	origin = 0;
+}
+
+// Allocate the buffer and start recording
+void ofxWinMenuTrace::Start(size_t nEvents)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events.assign(nEvents, event{});
+	nRecorded = 0;
+	origin = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	bRecording = true;
+}
+
+// Stop recording, the events are kept
+void ofxWinMenuTrace::Stop()
+{
+	bRecording = false;
+}
+
+// Any thread can read the time while recording is started by another
+int64_t ofxWinMenuTrace::Now() const
+{
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return now - origin.load(std::memory_order_relaxed);
+}
+
+void ofxWinMenuTrace::Record(const char *name, int id, char phase, int64_t start, int64_t duration)
+{
+	if (!IsRecording())
+		return;
+	uint32_t thread = (uint32_t)GetCurrentThreadId();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (events.empty())
+		return;
+	events[nRecorded % events.size()] = { name, id, phase, thread, start, duration };
+	nRecorded++;
+}
+
+void ofxWinMenuTrace::GetEvents(std::vector<event> &copy)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	copy.clear();
+	size_t n = (std::min)(nRecorded, events.size());
+	copy.reserve(n);
+	for (size_t i = nRecorded - n; i < nRecorded; i++)
+		copy.push_back(events[i % events.size()]);
+	// Spans are recorded when they end, so sort by start time
+	std::stable_sort(copy.begin(), copy.end(), [](const event &a, const event &b) { return a.start < b.start; });
+}
+
+size_t ofxWinMenuTrace::GetDropped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return (nRecorded > events.size()) ? nRecorded - events.size() : 0;
+}
+
+ofxWinMenuTrace::span::span(ofxWinMenuTrace *trace, const char *name, int id)
+{
+	this->trace = (trace && trace->IsRecording()) ? trace : nullptr;
+	this->name = name;
+	this->id = id;
+	start = this->trace ? this->trace->Now() : 0;
+}
+
+ofxWinMenuTrace::span::~span()
+{
+	if (trace)
+		trace->Record(name, id, 'X', start, trace->Now() - start);
+}
+
+
+//
+// Our local window message callback procedure
+//
+LRESULT CALLBACK ofxWinMenuWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam, UINT_PTR uIdSubclass, DWORD_PTR dwRefData)
+{
+	// The menu object of this window
+	ofxWinMenu *pThis = (ofxWinMenu *)dwRefData;
+	if(!pThis)
+		return DefSubclassProc(hWnd, uMsg, wParam, lParam);
+
+	// Menu item ID
+	int wmId = (int)LOWORD(wParam);
+
+	// Item changes posted by other threads
+	if(uMsg == postedMessage) {
+		pThis->ProcessPosted();
+		return 0;
+	}
 
 	switch (uMsg) {	
 
@@ -442,47 +3295,58 @@ LRESULT CALLBACK ofxWinMenuWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM l
 			break;
 
 		case WM_ENTERMENULOOP:
+			if(pThis->trace->IsRecording())
+				pThis->traceLoopStart = pThis->trace->Now();
 			// Inform ofApp of menu entry
-			pThis->MenuFunction("WM_ENTERMENULOOP", true);
+			pThis->MenuFunction(menuLoopEnter, true);
 			break;
 
 		case WM_EXITMENULOOP :
+			// Time the menu was open
+			if(pThis->trace->IsRecording() && pThis->traceLoopStart >= 0)
+				pThis->trace->Record("Menu loop", -1, 'X', pThis->traceLoopStart, pThis->trace->Now() - pThis->traceLoopStart);
+			pThis->traceLoopStart = -1;
 			// Inform ofApp of menu exit
-			pThis->MenuFunction("WM_EXITMENULOOP", true);
+			pThis->MenuFunction(menuLoopExit, true);
+			break;
+
+		case WM_KEYDOWN:
+		case WM_SYSKEYDOWN:
+			// Accelerator keys select menu items, not repeated while the key is held
+			if(!(lParam & 0x40000000) && pThis->KeyCommand((int)wParam))
+				return 0;
+			break;
+
+		case WM_INITMENUPOPUP:
+			// Fill a lazy popup menu before it opens
+			pThis->InitLazyPopupMenu((HMENU)wParam);
 			break;
 
 		case WM_COMMAND:
+			// Inform ofApp which menu item has been selected
+			pThis->MenuCommand(wmId);
+			break;
 
-			// Inform ofApp which menu has been selected
-			hSubMenu = pThis->subMenus.at(wmId); // Submenu that the menu item is in
-			ID = pThis->itemIDs.at(wmId); // Position of the item in the submenu
-
-			// Check the menu item if autocheck is enabled for it
-			if(pThis->autoCheck.at(wmId)) {
-				if(pThis->isChecked.at(wmId)) // currently checked
-					CheckMenuItem (hSubMenu, ID, MF_BYPOSITION | MF_UNCHECKED); // uncheck it
-				else
-					CheckMenuItem (hSubMenu, ID, MF_BYPOSITION | MF_CHECKED); // otherwise check it
-				pThis->isChecked.at(wmId) = !pThis->isChecked.at(wmId); // toggle the menu item state flag
+		case WM_CLOSE:           // Close Message
+			// Closing the main window ends the application.
+			// Other windows are closed by their own procedure.
+			if(pThis->bQuitOnClose) {
+				PostQuitMessage(0);  // Send A Quit Message
+				return 0;            // Jump Back
 			}
-			
-			// Get the menu item title
-			GetMenuStringA(hSubMenu, wmId, (LPSTR)title, MAX_PATH, MF_BYCOMMAND);
-
-			// Inform ofApp of the menu item title and new state
-			pThis->MenuFunction(title, pThis->isChecked.at(wmId));
+			break;
 
+		case WM_NCDESTROY:
+			// The window is destroyed, remove our procedure
+			RemoveWindowSubclass(hWnd, ofxWinMenuWndProc, uIdSubclass);
+			pThis->bSubclassed = false;
 			break;
 
-		case WM_CLOSE: {         // Close Message
-			PostQuitMessage(0);  // Send A Quit Message
-			return 0;            // Jump Back
-		}
 		// Openframeworks handles key and mouse and drag/drop etc.
 	}
 
 	// Pass unhandled messages on to the openframeworks application
-	return(CallWindowProc(ofAppWndProc, hWnd, uMsg, wParam, lParam));
+	return(DefSubclassProc(hWnd, uMsg, wParam, lParam));
 
 }
 
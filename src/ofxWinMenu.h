@@ -30,22 +30,269 @@
 
 #include <Windows.h>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <future>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
 #include <io.h> // For _access
 #include <Shlwapi.h> // For path functions
 #pragma comment(lib, "Shlwapi.Lib")
 
+//
+// Define OFXWINMENU_METRICS in the project preprocessor definitions
+// to record the number of selections and the time taken by each menu command.
+// Without it, nothing is recorded. The class is the same either way, so
+// the definition is only required where ofxWinMenu.cpp is compiled.
+//
+// #define OFXWINMENU_METRICS
+//
+
 
 class ofApp; // Forward declaration
 
+//
+// Menu definition
+//
+// A menu can be defined by a constant array, with popup menus ended by OFXMENU_END.
+//
+//     static constexpr ofxWinMenuDef appMenu[] = {
+//         { OFXMENU_POPUP, "File" },
+//             { OFXMENU_ITEM, "Open", false, false },
+//             { OFXMENU_SEPARATOR },
+//             { OFXMENU_ITEM, "Exit", false, false },
+//         { OFXMENU_END },
+//         { OFXMENU_POPUP, "View" },
+//             { OFXMENU_ITEM, "Show info", true },
+//         { OFXMENU_END },
+//     };
+//
+//     menu->CreateMenuFromDef(appMenu);
+//
+// The item numbers are then known at compile time and ofxWinMenuID can be
+// used for case labels in an ofApp function receiving the item number.
+//
+//     menu->CreateMenuFunction(&ofApp::appMenuCommand);
+//
+//     void ofApp::appMenuCommand(int item, bool bChecked) {
+//         switch(item) {
+//             case ofxWinMenuID(appMenu, "Exit") : ofExit(); break;
+//             case ofxWinMenuID(appMenu, "Show info") : bShowInfo = bChecked; break;
+//         }
+//     }
+//
+// Case labels are found by the compiler, so a name that is not in the menu
+// does not compile. Elsewhere ofxWinMenuID can be evaluated at run time and
+// throws if the name is not found. OFXWINMENU_ID is always found by the
+// compiler, so a name that is not in the menu does not compile.
+//
+//     int id = OFXWINMENU_ID(appMenu, "Show info");
+//
+enum ofxWinMenuType {
+	OFXMENU_ITEM,      // Popup menu item
+	OFXMENU_POPUP,     // Popup menu
+	OFXMENU_SEPARATOR, // Item separator
+	OFXMENU_END        // End of popup menu
+};
+
+struct ofxWinMenuDef {
+	ofxWinMenuType type;
+	const char *name = nullptr;
+	bool bChecked = false;   // Initial checked state
+	bool bAutoCheck = true;  // Check the item on and off
+	bool bEnabled = true;    // Initial enabled state
+};
+
+// Compare names at compile time
+constexpr bool ofxWinMenuNameEqual(const char *a, const char *b)
+{
+	while (*a && *a == *b) { a++; b++; }
+	return (*a == *b);
+}
+
+// Item number of a named item in a menu definition
+template<size_t N>
+constexpr int ofxWinMenuID(const ofxWinMenuDef (&def)[N], const char *name)
+{
+	int item = 0;
+	for (size_t i = 0; i < N; i++) {
+		if (def[i].type == OFXMENU_ITEM) {
+			if (ofxWinMenuNameEqual(def[i].name, name))
+				return item;
+			item++;
+		}
+		// Separators also have an item number
+		else if (def[i].type == OFXMENU_SEPARATOR) {
+			item++;
+		}
+	}
+	throw "ofxWinMenuID - item not found";
+}
+
+// Item number found by the compiler wherever it is used
+#define OFXWINMENU_ID(def, name) (std::integral_constant<int, ofxWinMenuID(def, name)>::value)
+
+//
+// Item flags that can be read by any thread without a lock.
+// Flags are packed in 64 bit words allocated in blocks that are never moved,
+// so adding items does not affect a thread reading the flags.
+// Flags are added only by the thread that owns the menu.
+//
+class ofxWinMenuFlags {
+
+	public:
+
+		ofxWinMenuFlags();
+		~ofxWinMenuFlags();
+
+		void push_back(bool bFlag);
+		void set(int item, bool bFlag);
+		bool operator[](int item) const;
+		int size() const;
+		void clear();
+
+		// Number of words and word containing the flag of an item
+		int words() const;
+		uint64_t word(int i) const;
+
+		// Word containing 64 flags, which are cleared
+		uint64_t take(int i);
+
+	private:
+
+		static const int blockWords = 1024; // 65536 flags for each block
+		static const int maxBlocks = 64;
+		std::atomic<std::atomic<uint64_t> *> blocks[maxBlocks];
+		std::atomic<int> count;
+
+};
+
+//
+// Trace of menu activity recorded in a ring buffer allocated when recording starts.
+// Events are recorded by any thread. When the buffer is full, the oldest events
+// are replaced. Times are nanoseconds from the start of recording.
+//
+class ofxWinMenuTrace {
+
+	public:
+
+		struct event {
+			const char *name; // Constant string
+			int id;           // Command ID, -1 if none
+			char phase;       // 'X' for a span, 'i' for an instant
+			uint32_t thread;
+			int64_t start;
+			int64_t duration;
+		};
+
+		// Span recorded from construction to destruction
+		class span {
+			public:
+				span(ofxWinMenuTrace *trace, const char *name, int id = -1);
+				~span();
+			private:
+				ofxWinMenuTrace *trace;
+				const char *name;
+				int id;
+				int64_t start;
+		};
+
+		ofxWinMenuTrace();
+
+		void Start(size_t nEvents);
+		void Stop();
+		bool IsRecording() const { return bRecording.load(std::memory_order_relaxed); }
+
+		// Time from the start of recording
+		int64_t Now() const;
+
+		void Record(const char *name, int id, char phase, int64_t start, int64_t duration);
+
+		// Recorded events, oldest first
+		void GetEvents(std::vector<event> &copy);
+
+		// Events replaced when the buffer was full
+		size_t GetDropped();
+
+	private:
+
+		std::atomic<bool> bRecording;
+		std::mutex mutex;
+		std::vector<event> events;
+		size_t nRecorded;
+		std::atomic<int64_t> origin; // Start of recording, steady clock nanoseconds
+
+};
+
+//
+// Menu backend
+//
+// ofxWinMenu records the items, their state and their order itself and
+// changes the menu shown to the user only through a backend. The default
+// backend calls the Windows menu functions. Another backend can be given
+// to the constructor, such as ofxWinMenuRecorder, which keeps the menus
+// in memory and counts the calls, so that the item model can be tested
+// and measured without a window.
+//
+// The functions are those of the Windows menu functions, with the same
+// flags. Positions are given with MF_BYPOSITION, otherwise command IDs.
+//
+class ofxWinMenuBackend {
+
+	public:
+
+		virtual ~ofxWinMenuBackend() {}
+
+		virtual HMENU CreateMenuBar() = 0; // CreateMenu
+		virtual HMENU CreatePopup() = 0; // CreatePopupMenu
+		virtual bool DestroyMenuHandle(HMENU hMenu) = 0; // DestroyMenu
+		virtual bool IsMenuHandle(HMENU hMenu) = 0; // IsMenu
+		virtual HMENU GetWindowMenu(HWND hwnd) = 0; // GetMenu
+		virtual bool SetWindowMenu(HWND hwnd, HMENU hMenu) = 0; // SetMenu
+		virtual bool RedrawMenuBar(HWND hwnd) = 0; // DrawMenuBar
+		virtual int GetItemCount(HMENU hMenu) = 0; // GetMenuItemCount
+		virtual bool InsertItem(HMENU hMenu, UINT position, UINT flags, UINT_PTR id, const char *text) = 0; // InsertMenuA
+		virtual bool AppendItem(HMENU hMenu, UINT flags, UINT_PTR id, const char *text) = 0; // AppendMenuA
+		virtual bool DeleteItem(HMENU hMenu, UINT position, UINT flags) = 0; // DeleteMenu
+		virtual bool CheckItem(HMENU hMenu, UINT item, UINT flags) = 0; // CheckMenuItem
+		virtual bool EnableItem(HMENU hMenu, UINT item, UINT flags) = 0; // EnableMenuItem
+		virtual bool SetItemText(HMENU hMenu, UINT item, UINT flags, const char *text) = 0; // SetMenuItemInfoA MIIM_STRING
+		virtual bool SetItemRadio(HMENU hMenu, UINT item, UINT flags) = 0; // SetMenuItemInfoA MFT_RADIOCHECK
+		virtual bool TrackPopup(HMENU hMenu, HWND hwnd) = 0; // TrackPopupMenu at the cursor
+
+		// Backend used if none is given to the constructor
+		static ofxWinMenuBackend *Default();
+
+};
+
+// Radio group returned by AddRadioGroup.
+// A separate type so that a group cannot be passed as an item number.
+struct ofxWinMenuGroup {
+	int id = -1;
+};
+
 class ofxWinMenu {
 
 	public:
 
-		ofxWinMenu(ofApp *app, HWND hwnd);
+		ofxWinMenu(ofApp *app, HWND hwnd, ofxWinMenuBackend *menuBackend = nullptr);
 		~ofxWinMenu();
 
+		ofxWinMenuBackend *backend; // Menu functions
 		HWND g_hwnd; // ofApp window
+		bool bSubclassed; // ofApp window message procedure subclassed
+		bool bQuitOnClose; // WM_CLOSE ends the application, main window only
 		HMENU g_hMenu; // ofApp menu we are building
 
 		// Main menu
@@ -54,15 +301,101 @@ class ofxWinMenu {
 		// Popup menu of the main menu
 		HMENU AddPopupMenu(HMENU hMenu, std::string menuName);
 
+		// Popup menu with items created by a function when it opens
+		HMENU AddLazyPopupMenu(HMENU hMenu, std::string menuName,
+			std::function<void(std::vector<std::string> &items)> provider,
+			std::function<void(int index, const std::string &name)> function, int maxItems = 0);
+
+		// The items of a lazy popup menu are created again when it next opens
+		bool InvalidateLazyPopupMenu(HMENU hPopup);
+
+		// Insert a popup menu before the entry at a position in the menu,
+		// or at the end if position is -1
+		HMENU InsertPopupMenuAt(HMENU hMenu, int position, std::string MenuName);
+
+		// The menu containing a popup menu, NULL if not a popup menu
+		HMENU GetParentMenu(HMENU hPopup);
+
+		// Number of items, separators and popup menus in a menu
+		int GetPopupCount(HMENU hMenu);
+
 		// Popup menu items
 		bool AddPopupItem(HMENU hSubMenu, std::string ItemName);
 		bool AddPopupItem(HMENU hSubMenu, std::string ItemName, bool bChecked);
 		bool AddPopupItem(HMENU hSubMenu, std::string ItemName, bool bChecked, bool bAutoCheck);
 		bool AddPopupSeparator(HMENU hSubMenu);
 
+		// Popup menu item returning the item number for use
+		// with the item functions, or -1 if the item is not added
+		int AddPopupItemID(HMENU hSubMenu, std::string ItemName, bool bChecked = false, bool bAutoCheck = true);
+
+		// Insert an item before the item at a position in the popup menu,
+		// or at the end if position is -1. Returns the item number or -1.
+		int InsertPopupItemAt(HMENU hSubMenu, int position, std::string ItemName, bool bChecked = false, bool bAutoCheck = true);
+
+		// Remove an item or separator from its popup menu
+		// The item number can be used again by a new item
+		bool RemovePopupItem(int item);
+		bool RemovePopupItem(std::string ItemName);
+
+		// Position of an item in its popup menu, -1 if not an item
+		int GetItemPosition(int item);
+
+		// Radio group of items with one item selected
+		ofxWinMenuGroup AddRadioGroup(std::string GroupName);
+
+		// Add an item to a radio group, returns the item number or -1
+		int AddRadioItem(HMENU hSubMenu, ofxWinMenuGroup group, std::string ItemName, bool bSelected = false);
+
+		// Select an item of a radio group
+		bool SelectRadioItem(int item);
+		bool SelectRadioItem(std::string ItemName);
+
+		// The selected item of a radio group, -1 if none
+		int GetRadioItem(ofxWinMenuGroup group);
+
+		// Keyboard accelerator of an item, such as "Ctrl+I"
+		bool SetItemAccelerator(int item, std::string key);
+		bool SetItemAccelerator(std::string ItemName, std::string key);
+
+		// Accelerator key code from text, -1 if not a key
+		static int ParseAccelerator(const std::string &key);
+
+		// Text of an accelerator key code
+		static std::string AcceleratorText(int code);
+
+		// Select the item of an accelerator key
+		bool KeyCommand(int vk);
+
+		// Context menu, created once and shown when required
+		HMENU CreateContextMenu();
+
+		// Add an item of the window menu to a context menu
+		// The item has the same item number, state and function
+		bool AddContextItem(HMENU hContextMenu, int item);
+		bool AddContextItem(HMENU hContextMenu, std::string ItemName);
+
+		// Show a context menu at the cursor position
+		bool ShowContextMenu(HMENU hContextMenu);
+
+		// Create a menu from a text description or a text file
+		bool CreateMenuFromText(std::string text);
+		bool CreateMenuFromFile(std::string filename);
+
+		// Create a menu from a definition before any items are added
+		bool CreateMenuFromDef(const ofxWinMenuDef *def, size_t nDefs);
+		template<size_t N>
+		bool CreateMenuFromDef(const ofxWinMenuDef (&def)[N]) { return CreateMenuFromDef(def, N); }
+
+		// Create menu items from a definition
+		bool BuildMenu(const ofxWinMenuDef *def, size_t nDefs);
+
 		// Set the menu to the application
 		bool SetWindowMenu();
 
+		// Closing the window ends the application
+		void SetQuitOnClose(bool bQuit);
+
 		// Remove the menu but do not destroy it
 		bool RemoveWindowMenu();
 
@@ -78,29 +411,376 @@ class ofxWinMenu {
 		// Get the checkmark state of a popup item
 		bool GetPopupItem(std::string ItemName);
 
+		// Item functions using the item number returned by AddPopupItemID
+		bool SetPopupItem(int item, bool bChecked);
+		bool EnablePopupItem(int item, bool bEnabled);
+		bool GetPopupItem(int item);
+
+		// Begin a group of item changes
+		// The menu is not changed until EndUpdate
+		void BeginUpdate();
+
+		// Show the changes made since BeginUpdate
+		bool EndUpdate();
+
+		// Number of menu changes saved by updates
+		int GetUpdateSaved();
+
+		// Post item changes from any thread
+		// The changes are made by the thread that owns the window
+		void PostSetPopupItem(int item, bool bChecked);
+		void PostSetPopupItem(std::string ItemName, bool bChecked);
+		void PostEnablePopupItem(int item, bool bEnabled);
+		void PostEnablePopupItem(std::string ItemName, bool bEnabled);
+
+		// Make the posted changes and return how many were made
+		int ProcessPosted();
+
+		// Copy the checked and enabled flags of all items, 64 items for each word.
+		// Any thread can take a snapshot. Returns the number of items.
+		int Snapshot(std::vector<uint64_t> &checked, std::vector<uint64_t> &enabled);
+
 		// Save item states to an initialization file with optional overwrite
 		void Save(std::string filename, bool bOverWrite = false);
 
+		// Save item states with a separate thread and return immediately
+		std::future<bool> SaveAsync(std::string filename, bool bOverWrite = false,
+			std::function<void(bool bSaved)> function = nullptr);
+
+		// SaveAsync writes not yet finished, waited for when the menu is deleted
+		std::vector<std::future<void>> saveWrites;
+
+		// Item states to save
+		void GetSaveKeys(std::vector<std::pair<std::string, std::string>> &keys);
+
 		// Load item states from an initialization file
 		bool Load(std::string filename);
 
+		// Save and load a binary copy of the item states with the initialization file,
+		// or instead of it with bBinaryOnly
+		void SetBinaryState(bool bBinary, bool bBinaryOnly = false);
+
+		// Binary state file path from the initialization file path
+		std::string GetBinaryPath(const std::string &inipath);
+
+		// The file written by Save
+		std::string GetSavePath(const std::string &inipath);
+
+		// Save and load the item states with a binary file
+		bool SaveBinary(const std::string &binpath);
+		bool LoadBinary(const std::string &binpath);
+
+		// Binary file data and write
+		uint32_t GetBinaryData(std::vector<uint64_t> &data);
+		static bool WriteBinary(const std::string &binpath, uint32_t nItems, const std::vector<uint64_t> &data);
+
+		// Binary state file is used
+		bool bBinaryState;
+		bool bBinaryOnly; // Initialization file not written by Save
+
+		// Save changed items to an initialization file after a quiet period
+		void SetAutoSave(std::string filename, int quietms = 1000);
+
+		// Stop auto save and save changes not yet saved
+		void StopAutoSave();
+
+		// Number of auto save file writes
+		int GetAutoSaveWrites();
+
+		// Number of changes saved by the same write as another change
+		int GetAutoSaveCoalesced();
+
+		// Initialization file name with ".ini" extension
+		std::string GetIniName(std::string filename);
+
+		// Full path of an initialization file
+		// A file name without a path is in the "bin\data" folder
+		std::string GetIniPath(const std::string &filename);
+
+		// Replace the keys of one section of initialization file text
+		static std::string MergeIniSection(const std::string &text, const std::string &section,
+			const std::vector<std::pair<std::string, std::string>> &keys);
+
+		// Read the keys of one section of initialization file text
+		static void ParseIniSection(const std::string &text, const std::string &section,
+			std::unordered_map<std::string, std::string> &keys);
+
+		// Read one section of an initialization file in one pass
+		static bool ReadIniSection(const std::string &inipath, const std::string &section,
+			std::unordered_map<std::string, std::string> &keys);
+
+		// Write one section of an initialization file in one pass
+		static bool WriteIniSection(const std::string &inipath, const std::string &section,
+			const std::vector<std::pair<std::string, std::string>> &keys);
+
 		// Create menu with ofApp function for return of memu item selection
 		void CreateMenuFunction(void(ofApp::*function)(std::string title, bool bChecked));
 
+		// ofApp function receiving the title without a string copy
+		void CreateMenuFunction(void(ofApp::*function)(std::string_view title, bool bChecked));
+
+		// ofApp function receiving the item number instead of the title
+		void CreateMenuFunction(void(ofApp::*function)(int item, bool bChecked));
+
 		// ofxWinMenu function to return menu item selection to ofApp
-		void MenuFunction(std::string title, bool bChecked);
+		void MenuFunction(const std::string &title, bool bChecked);
+
+		// Function called for selection of an item instead of the menu function
+		bool SetItemFunction(int item, std::function<void(bool bChecked)> function);
+		bool SetItemFunction(int item, void(ofApp::*function)(bool bChecked));
+
+		// Return the item state by the item function or the menu function
+		void ItemFunction(int item);
+
+		// Selection of a menu item
+		bool MenuCommand(int id);
+		bool DispatchCommand(int id);
+
+		// Trace of menu activity
+		// Start recording with room for a number of events
+		bool StartTrace(int nEvents = 65536);
+		void StopTrace();
+
+		// Instant event for ofApp, such as a frame marker
+		// The name must be a constant string
+		void TraceMark(const char *name);
+
+		// Trace Event JSON for a trace viewer
+		std::string GetTraceJSON();
+		bool SaveTrace(std::string filename);
+
+		// Recorder shared with threads writing files
+		std::shared_ptr<ofxWinMenuTrace> trace;
+		int64_t traceLoopStart; // Time of WM_ENTERMENULOOP, -1 if none
+
+		// Command metrics, recorded with OFXWINMENU_METRICS defined
+		int GetCommandCount(int id);
+		double GetCommandLatency(int id, double fraction); // Microseconds, 0.5 for p50, 0.99 for p99
+		double GetCommandMaxLatency(int id); // Microseconds
+		std::string GetMetricsText();
+		void ResetMetrics();
+
+		// Selections of a command and the time taken
+		// The same in all builds, empty without OFXWINMENU_METRICS
+		static const int metricBuckets = 32; // Powers of two microseconds
+		struct commandMetric {
+			uint64_t count = 0;
+			double maxTime = 0.0; // Microseconds
+			uint32_t buckets[metricBuckets] = {};
+		};
+		std::unordered_map<int, commandMetric> commandMetrics;
+		void RecordCommand(int id, std::chrono::steady_clock::duration elapsed);
 
 		// Pointer to access the ofApp class
 		ofApp *pApp;
 
 		// The ofApp menu function
 		void(ofApp::*pAppMenuFunction)(std::string title, bool bChecked);
+		void(ofApp::*pAppMenuViewFunction)(std::string_view title, bool bChecked);
+		void(ofApp::*pAppItemFunction)(int item, bool bChecked);
 
 		// Menu item data
 		std::vector<std::string> itemNames; // Name of the menu item
 		std::vector<HMENU> subMenus;   // Submenu containing the menu item
-		std::vector<int> itemIDs;      // Position of the item in the submenu
+		std::vector<int> itemNodes;    // Order node of the item in the submenu
 		std::vector<bool> autoCheck;   // Check the menu item on and off
-		std::vector<bool> isChecked;   // Item checked flag
+		ofxWinMenuFlags isChecked;     // Item checked flag
+		ofxWinMenuFlags isEnabled;     // Item enabled flag
+		std::vector<std::function<void(bool)>> itemFunctions; // Item selection function
+		std::vector<bool> menuChecked; // Checked state shown by the menu
+		std::vector<bool> menuEnabled; // Enabled state shown by the menu
+		std::vector<bool> isPending;   // Item changed during an update
+		std::vector<int> itemGroups;   // Radio group of the item, -1 if none
+		std::vector<int> itemKeys;     // Accelerator key code of the item, 0 if none
+
+		// Item number from the accelerator key code
+		std::unordered_map<int, int> keyIndex;
+		static const int keyCtrl  = 1 << 16;
+		static const int keyShift = 1 << 17;
+		static const int keyAlt   = 1 << 18;
+
+		// Item text with the accelerator key
+		std::string GetItemText(int item);
+
+		// Context menus
+		std::vector<HMENU> contextMenus;
+
+		// Items added to context menus, with the context menu and the order node
+		std::unordered_multimap<int, std::pair<HMENU, int>> itemMirrors;
+
+		// Radio groups
+		struct radioGroup {
+			std::string name;
+			int selected; // Selected item, -1 if none
+		};
+		std::vector<radioGroup> radioGroups;
+
+		// Update data
+		int nUpdates;    // BeginUpdate count
+		int nUpdateCalls; // Menu changes requested during updates
+		int nUpdateSaved; // Menu changes not required
+		std::vector<int> updateItems; // Items changed during an update
+
+		// Lazy popup menus
+		struct lazyMenu {
+			HMENU hMenu;
+			std::function<void(std::vector<std::string> &items)> provider;
+			std::function<void(int index, const std::string &name)> function;
+			int maxItems;
+			int firstID; // First command ID of the items
+			unsigned int generation; // Changed by InvalidateLazyPopupMenu
+			unsigned int created;    // Generation of the items created
+			std::vector<std::string> items;
+		};
+		std::vector<lazyMenu> lazyMenus;
+		std::unordered_map<HMENU, int> lazyIndex; // Lazy menu from the popup menu handle
+		int lazyFirstID; // First command ID of lazy menu items, item numbers are below
+		static const int maxCommandID = 0x10000; // Command IDs are 16 bit
+		static const int lazyBlockSize = 0x1000; // Largest number of items of a lazy menu
+		static const int maxLazyMenus = 8;
+		bool InitLazyPopupMenu(HMENU hPopup);
+		int LazyMenuFromID(int id);
+		bool LazyMenuCommand(int id);
+
+		// Item change posted by another thread
+		struct postedChange {
+			postedChange *next;
+			int item; // Item number or -1 for the item name
+			std::string name;
+			bool bEnable; // Enable instead of check
+			bool bState;
+		};
+
+		// Posted changes, most recent first
+		std::atomic<postedChange *> postedChanges;
+
+		// Add a change to the posted changes
+		void PostChange(postedChange *change);
+
+		// Item numbers from the item name
+		std::unordered_multimap<std::string, int> itemIndex;
+
+		// Find the item number of a named item, -1 if not found
+		int FindItem(const std::string &ItemName);
+
+		// The item number is in use
+		bool IsItem(int item);
+
+		// Item numbers of removed items, a heap with the lowest first
+		std::vector<int> freeItems;
+
+		//
+		// Submenu order
+		//
+		// The entries of each submenu are nodes of a tree ordered by position.
+		// Each node records the size of its subtree, so the position of a node
+		// is found, and a node inserted or removed at a position, in O(log n)
+		// without renumbering the entries that follow.
+		//
+		struct orderNode {
+			int left;   // Entries before
+			int right;  // Entries after
+			int parent; // -1 for the root
+			int size;   // Number of nodes in the subtree
+			uint32_t priority; // Random, larger nearer the root
+			int item;   // Item number, -1 for a popup menu
+			HMENU hMenu; // Submenu containing the entry
+		};
+		std::vector<orderNode> orderNodes;
+		std::vector<int> freeNodes;
+		std::unordered_map<HMENU, int> orderRoots; // Root node of each submenu
+		uint32_t orderRandom;
+		int NewOrderNode(HMENU hMenu, int item);
+		int OrderSize(int node);
+		void OrderUpdate(int node);
+		int OrderMerge(int a, int b);
+		void OrderSplit(int node, int count, int &a, int &b);
+		void OrderInsert(int node, int position);
+		void OrderRemove(int node);
+		int OrderPosition(int node);
+		int OrderCount(HMENU hMenu);
+
+		// Popup menus of any depth and the menu containing each
+		struct popupMenu {
+			HMENU hParent; // Menu containing the popup menu
+			int node;      // Order node of the popup menu in the parent
+		};
+		std::unordered_map<HMENU, popupMenu> popupMenus;
+
+		//
+		// Item table
+		//
+		// Item data is recorded and changed without using Windows menu functions.
+		// The Windows menu is then updated from the item data by the menu functions.
+		//
+
+		// Add an item to the table and return the item number
+		int AddItem(HMENU hSubMenu, int position, const std::string &ItemName, bool bChecked, bool bAutoCheck);
+
+		// Remove an item from the table
+		void RemoveItem(int item);
+
+		// Copy the names of an item for auto save
+		void SetAutoSaveName(int item);
+
+		// Reserve space for a number of items
+		void ReserveItems(int nItems);
+
+		// Set item states, return true if the state has changed
+		bool SetItemChecked(int item, bool bChecked);
+		bool SetItemEnabled(int item, bool bEnabled);
+
+		// Record an item changed during an update
+		void SetItemPending(int item);
+
+		// Changed items not yet saved by auto save
+		ofxWinMenuFlags isDirty;
+		void SetItemDirty(int item);
+		void AutoSaveWrite(const std::vector<std::pair<std::string, std::string>> &keys);
+
+		// Auto save data
+		bool bAutoSave;
+		bool bAutoSaveQuit;
+		bool bAutoSavePending;
+		std::string autoSavePath;
+		std::string autoSaveBinaryPath;
+		std::vector<std::string> autoSaveNames; // Names of auto check and radio items
+		std::vector<std::string> autoSaveGroups; // Group names of radio items
+		std::chrono::milliseconds autoSaveQuiet;
+		std::chrono::steady_clock::time_point autoSaveTime; // Time of the last change
+		std::thread autoSaveThread;
+		std::mutex autoSaveMutex;
+		std::condition_variable autoSaveCondition;
+		std::atomic<int> nAutoSaveWrites;
+		std::atomic<int> nAutoSaveChanges;
+		void AutoSaveThread();
+		void GetDirtyKeys(std::vector<std::pair<std::string, std::string>> &keys);
+
+		// Sequence number of flag changes, odd while a change is made
+		std::atomic<unsigned int> flagSequence;
+		void BeginFlagChange();
+		void EndFlagChange();
+
+		//
+		// Windows menu functions
+		//
+		// These are the only functions that change the Windows menu items.
+		//
+
+		// The menu exists and can be changed
+		bool IsMenuValid();
+
+		// Insert an item or separator at the position recorded for it
+		bool MenuInsertItem(int item);
+
+		// Delete an item or separator from its submenu and context menus
+		bool MenuRemoveItem(int item);
+
+		// Insert an item in a context menu
+		bool MenuInsertMirror(int item, HMENU hMenu, int node);
+
+		// Show the checked and enabled state of an item
+		void MenuCheckItem(int item);
+		void MenuEnableItem(int item);
 
 };
@@ -0,0 +1,309 @@
+/*
+
+	ofxWinMenuRecorder
+
+	Menu backend for ofxWinMenu that keeps the menus in memory
+	and counts the menu function calls.
+
+	Copyright (C) 2016-2025 Lynn Jarvis.
+
+	https://github.com/leadedge
+
+	http://www.spout.zeal.co
+
+    =========================================================================
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    =========================================================================
+
+	16.10.26 - Menus kept in memory with the entries of each command ID
+
+*/
+#include "ofxWinMenuRecorder.h"
+
+ofxWinMenuRecorder::ofxWinMenuRecorder()
+{
+	trackedMenu = NULL;
+	ResetCalls();
+}
+
+HMENU ofxWinMenuRecorder::NewMenu()
+{
+	menus.emplace_back();
+	menus.back().bValid = true;
+	return (HMENU)(firstHandle + menus.size() - 1);
+}
+
+ofxWinMenuRecorder::menuData *ofxWinMenuRecorder::GetMenuData(HMENU hMenu)
+{
+	uintptr_t index = (uintptr_t)hMenu - firstHandle;
+	if((uintptr_t)hMenu < firstHandle || index >= menus.size() || !menus[index].bValid)
+		return nullptr;
+	return &menus[index];
+}
+
+// Entry of an item by position or by command ID
+// A command ID is found in popup menus of the menu as well
+int ofxWinMenuRecorder::FindEntry(HMENU hMenu, UINT item, UINT flags, HMENU *hFound)
+{
+	menuData *menu = GetMenuData(hMenu);
+	if(!menu)
+		return -1;
+	if(hFound)
+		*hFound = hMenu;
+	if(flags & MF_BYPOSITION) {
+		if(item >= menu->order.size())
+			return -1;
+		return menu->order[item];
+	}
+	auto it = menu->commands.find(item);
+	if(it != menu->commands.end())
+		return it->second;
+	for(int e : menu->order) {
+		if(entries[e].bPopup) {
+			int found = FindEntry((HMENU)entries[e].id, item, flags, hFound);
+			if(found >= 0)
+				return found;
+		}
+	}
+	return -1;
+}
+
+HMENU ofxWinMenuRecorder::CreateMenuBar()
+{
+	calls[CALL_CREATE_MENU]++;
+	return NewMenu();
+}
+
+HMENU ofxWinMenuRecorder::CreatePopup()
+{
+	calls[CALL_CREATE_POPUP]++;
+	return NewMenu();
+}
+
+// A menu is destroyed with its popup menus
+bool ofxWinMenuRecorder::DestroyMenuHandle(HMENU hMenu)
+{
+	calls[CALL_DESTROY]++;
+	menuData *menu = GetMenuData(hMenu);
+	if(!menu)
+		return false;
+	std::vector<int> order;
+	order.swap(menu->order);
+	menu->commands.clear();
+	menu->bValid = false;
+	for(int e : order) {
+		if(entries[e].bPopup) {
+			DestroyMenuHandle((HMENU)entries[e].id);
+			calls[CALL_DESTROY]--;
+		}
+		entries[e].text.clear();
+		freeEntries.push_back(e);
+	}
+	return true;
+}
+
+bool ofxWinMenuRecorder::IsMenuHandle(HMENU hMenu)
+{
+	calls[CALL_IS_MENU]++;
+	return GetMenuData(hMenu) != nullptr;
+}
+
+HMENU ofxWinMenuRecorder::GetWindowMenu(HWND hwnd)
+{
+	calls[CALL_GET_MENU]++;
+	auto it = windowMenus.find(hwnd);
+	return it == windowMenus.end() ? NULL : it->second;
+}
+
+bool ofxWinMenuRecorder::SetWindowMenu(HWND hwnd, HMENU hMenu)
+{
+	calls[CALL_SET_MENU]++;
+	if(!hwnd || (hMenu && !GetMenuData(hMenu)))
+		return false;
+	if(hMenu)
+		windowMenus[hwnd] = hMenu;
+	else
+		windowMenus.erase(hwnd);
+	return true;
+}
+
+bool ofxWinMenuRecorder::RedrawMenuBar(HWND hwnd)
+{
+	calls[CALL_DRAW_MENU_BAR]++;
+	return hwnd != NULL;
+}
+
+int ofxWinMenuRecorder::GetItemCount(HMENU hMenu)
+{
+	calls[CALL_GET_COUNT]++;
+	menuData *menu = GetMenuData(hMenu);
+	return menu ? (int)menu->order.size() : -1;
+}
+
+// Insert before the entry at a position, at the end if there is none
+// Only insertion by position is supported
+bool ofxWinMenuRecorder::InsertItem(HMENU hMenu, UINT position, UINT flags, UINT_PTR id, const char *text)
+{
+	calls[CALL_INSERT]++;
+	menuData *menu = GetMenuData(hMenu);
+	if(!menu || !(flags & MF_BYPOSITION))
+		return false;
+	if(menu->commands.count(id))
+		return false;
+
+	int e;
+	if(!freeEntries.empty()) {
+		e = freeEntries.back();
+		freeEntries.pop_back();
+	}
+	else {
+		e = (int)entries.size();
+		entries.emplace_back();
+	}
+	entry &item = entries[e];
+	item.id = id;
+	item.bSeparator = (flags & MF_SEPARATOR) != 0;
+	item.bPopup = (flags & MF_POPUP) != 0;
+	item.bChecked = (flags & MF_CHECKED) != 0;
+	item.bEnabled = (flags & (MF_DISABLED | MF_GRAYED)) == 0;
+	item.bRadio = false;
+	if(text && !item.bSeparator)
+		item.text = text;
+	else
+		item.text.clear();
+
+	if(position >= menu->order.size())
+		menu->order.push_back(e);
+	else
+		menu->order.insert(menu->order.begin() + position, e);
+	menu->commands[id] = e;
+	return true;
+}
+
+bool ofxWinMenuRecorder::AppendItem(HMENU hMenu, UINT flags, UINT_PTR id, const char *text)
+{
+	calls[CALL_APPEND]++;
+	bool bInserted = InsertItem(hMenu, (UINT)-1, flags | MF_BYPOSITION, id, text);
+	calls[CALL_INSERT]--;
+	return bInserted;
+}
+
+// A popup menu deleted from a menu is destroyed
+bool ofxWinMenuRecorder::DeleteItem(HMENU hMenu, UINT position, UINT flags)
+{
+	calls[CALL_DELETE]++;
+	HMENU hFound = NULL;
+	int e = FindEntry(hMenu, position, flags, &hFound);
+	if(e < 0)
+		return false;
+	menuData *menu = GetMenuData(hFound);
+	if(flags & MF_BYPOSITION)
+		menu->order.erase(menu->order.begin() + position);
+	else
+		menu->order.erase(std::find(menu->order.begin(), menu->order.end(), e));
+	menu->commands.erase(entries[e].id);
+	if(entries[e].bPopup) {
+		DestroyMenuHandle((HMENU)entries[e].id);
+		calls[CALL_DESTROY]--;
+	}
+	entries[e].text.clear();
+	freeEntries.push_back(e);
+	return true;
+}
+
+bool ofxWinMenuRecorder::CheckItem(HMENU hMenu, UINT item, UINT flags)
+{
+	calls[CALL_CHECK]++;
+	int e = FindEntry(hMenu, item, flags, nullptr);
+	if(e < 0)
+		return false;
+	entries[e].bChecked = (flags & MF_CHECKED) != 0;
+	return true;
+}
+
+bool ofxWinMenuRecorder::EnableItem(HMENU hMenu, UINT item, UINT flags)
+{
+	calls[CALL_ENABLE]++;
+	int e = FindEntry(hMenu, item, flags, nullptr);
+	if(e < 0)
+		return false;
+	entries[e].bEnabled = (flags & (MF_DISABLED | MF_GRAYED)) == 0;
+	return true;
+}
+
+bool ofxWinMenuRecorder::SetItemText(HMENU hMenu, UINT item, UINT flags, const char *text)
+{
+	calls[CALL_SET_TEXT]++;
+	int e = FindEntry(hMenu, item, flags, nullptr);
+	if(e < 0)
+		return false;
+	entries[e].text = text ? text : "";
+	return true;
+}
+
+bool ofxWinMenuRecorder::SetItemRadio(HMENU hMenu, UINT item, UINT flags)
+{
+	calls[CALL_SET_RADIO]++;
+	int e = FindEntry(hMenu, item, flags, nullptr);
+	if(e < 0)
+		return false;
+	entries[e].bRadio = true;
+	return true;
+}
+
+bool ofxWinMenuRecorder::TrackPopup(HMENU hMenu, HWND hwnd)
+{
+	calls[CALL_TRACK]++;
+	if(!hwnd || !GetMenuData(hMenu))
+		return false;
+	trackedMenu = hMenu;
+	return true;
+}
+
+const ofxWinMenuRecorder::entry *ofxWinMenuRecorder::GetEntry(HMENU hMenu, UINT item, UINT flags)
+{
+	int e = FindEntry(hMenu, item, flags, nullptr);
+	return e < 0 ? nullptr : &entries[e];
+}
+
+int ofxWinMenuRecorder::GetPosition(HMENU hMenu, UINT_PTR id)
+{
+	menuData *menu = GetMenuData(hMenu);
+	if(!menu)
+		return -1;
+	auto it = menu->commands.find(id);
+	if(it == menu->commands.end())
+		return -1;
+	auto pos = std::find(menu->order.begin(), menu->order.end(), it->second);
+	return (int)(pos - menu->order.begin());
+}
+
+size_t ofxWinMenuRecorder::GetCalls(function f) const
+{
+	return calls[f];
+}
+
+size_t ofxWinMenuRecorder::GetCalls() const
+{
+	size_t total = 0;
+	for(size_t n : calls)
+		total += n;
+	return total;
+}
+
+void ofxWinMenuRecorder::ResetCalls()
+{
+	for(size_t &n : calls)
+		n = 0;
+}
@@ -0,0 +1,135 @@
+/*
+
+	ofxWinMenuRecorder
+
+	Menu backend for ofxWinMenu that keeps the menus in memory
+	and counts the menu function calls, for tests and benchmarks
+	of the item model without a window.
+
+	Copyright (C) 2016-2025 Lynn Jarvis.
+
+	https://github.com/leadedge
+
+	http://www.spout.zeal.co
+
+    =========================================================================
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+    =========================================================================
+
+*/
+#pragma once
+
+#include "ofxWinMenu.h"
+
+//
+// The menus are kept as the Windows menu functions would change them.
+// Handles are numbers from 0x10000, above the 16 bit command IDs of
+// items in the same menu, and are not valid Windows menu handles.
+//
+//     ofxWinMenuRecorder recorder;
+//     ofxWinMenu *menu = new ofxWinMenu(this, hwnd, &recorder);
+//     ...
+//     const ofxWinMenuRecorder::entry *e = recorder.GetEntry(hPopup, 0, MF_BYPOSITION);
+//     bool bChecked = e && e->bChecked;
+//
+class ofxWinMenuRecorder : public ofxWinMenuBackend {
+
+	public:
+
+		// Counted menu functions
+		enum function {
+			CALL_CREATE_MENU,
+			CALL_CREATE_POPUP,
+			CALL_DESTROY,
+			CALL_IS_MENU,
+			CALL_GET_MENU,
+			CALL_SET_MENU,
+			CALL_DRAW_MENU_BAR,
+			CALL_GET_COUNT,
+			CALL_INSERT,
+			CALL_APPEND,
+			CALL_DELETE,
+			CALL_CHECK,
+			CALL_ENABLE,
+			CALL_SET_TEXT,
+			CALL_SET_RADIO,
+			CALL_TRACK,
+			CALL_FUNCTIONS
+		};
+
+		// Menu entry as shown to the user
+		struct entry {
+			UINT_PTR id = 0; // Command ID or popup menu handle
+			bool bSeparator = false;
+			bool bPopup = false;
+			bool bChecked = false;
+			bool bEnabled = true;
+			bool bRadio = false;
+			std::string text;
+		};
+
+		ofxWinMenuRecorder();
+
+		HMENU CreateMenuBar();
+		HMENU CreatePopup();
+		bool DestroyMenuHandle(HMENU hMenu);
+		bool IsMenuHandle(HMENU hMenu);
+		HMENU GetWindowMenu(HWND hwnd);
+		bool SetWindowMenu(HWND hwnd, HMENU hMenu);
+		bool RedrawMenuBar(HWND hwnd);
+		int GetItemCount(HMENU hMenu);
+		bool InsertItem(HMENU hMenu, UINT position, UINT flags, UINT_PTR id, const char *text);
+		bool AppendItem(HMENU hMenu, UINT flags, UINT_PTR id, const char *text);
+		bool DeleteItem(HMENU hMenu, UINT position, UINT flags);
+		bool CheckItem(HMENU hMenu, UINT item, UINT flags);
+		bool EnableItem(HMENU hMenu, UINT item, UINT flags);
+		bool SetItemText(HMENU hMenu, UINT item, UINT flags, const char *text);
+		bool SetItemRadio(HMENU hMenu, UINT item, UINT flags);
+		bool TrackPopup(HMENU hMenu, HWND hwnd);
+
+		// Entry at a position with MF_BYPOSITION, otherwise of a command ID,
+		// NULL if there is none
+		const entry *GetEntry(HMENU hMenu, UINT item, UINT flags);
+
+		// Position of a command ID or popup menu in a menu, -1 if not found
+		int GetPosition(HMENU hMenu, UINT_PTR id);
+
+		// Number of calls of a function and of all functions
+		size_t GetCalls(function f) const;
+		size_t GetCalls() const;
+		void ResetCalls();
+
+		// Menu shown by the last TrackPopup
+		HMENU trackedMenu;
+
+	private:
+
+		struct menuData {
+			bool bValid = false;
+			std::vector<int> order; // Entries in menu order
+			std::unordered_map<UINT_PTR, int> commands; // Entry of each ID
+		};
+
+		menuData *GetMenuData(HMENU hMenu);
+		int FindEntry(HMENU hMenu, UINT item, UINT flags, HMENU *hFound);
+		HMENU NewMenu();
+
+		static const uintptr_t firstHandle = 0x10000;
+		std::vector<menuData> menus; // Handle is the index + firstHandle
+		std::vector<entry> entries;
+		std::vector<int> freeEntries;
+		std::unordered_map<HWND, HMENU> windowMenus;
+		size_t calls[CALL_FUNCTIONS];
+
+};
@@ -0,0 +1,6 @@
+// Headless build - see Windows.h
+#pragma once
+
+#include <Windows.h>
+
+BOOL PathRemoveFileSpecA(LPSTR path);
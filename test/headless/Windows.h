@@ -0,0 +1,129 @@
+//
+// Headless build
+//
+// The part of the Windows API used by ofxWinMenu, for building and testing
+// the item model without Windows. Menus are changed through a backend such
+// as ofxWinMenuRecorder. Windows are numbers with a window procedure and
+// properties, files are POSIX files. See headless.h for the test functions.
+//
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+typedef struct HWND__ *HWND;
+typedef struct HMENU__ *HMENU;
+typedef struct HINSTANCE__ *HMODULE;
+typedef void *HANDLE;
+typedef unsigned int UINT;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t UINT_PTR;
+typedef uintptr_t DWORD_PTR;
+typedef int BOOL;
+typedef char *LPSTR;
+typedef const char *LPCSTR;
+typedef unsigned long DWORD;
+typedef unsigned short WORD;
+typedef short SHORT;
+
+#define CALLBACK
+#define WINAPI
+#ifndef NULL
+#define NULL 0
+#endif
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+
+typedef LRESULT (CALLBACK *WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+
+#define LOWORD(x) ((WORD)((uintptr_t)(x) & 0xffff))
+#define HIWORD(x) ((WORD)(((uintptr_t)(x) >> 16) & 0xffff))
+
+enum { GWLP_WNDPROC = -4, GCLP_MENUNAME = -8 };
+
+enum {
+	MF_BYCOMMAND = 0x0, MF_STRING = 0x0, MF_UNCHECKED = 0x0, MF_ENABLED = 0x0,
+	MF_GRAYED = 0x1, MF_DISABLED = 0x2, MF_CHECKED = 0x8, MF_POPUP = 0x10,
+	MF_BYPOSITION = 0x400, MF_SEPARATOR = 0x800
+};
+
+enum {
+	VK_BACK = 0x08, VK_TAB = 0x09, VK_RETURN = 0x0D, VK_SHIFT = 0x10, VK_CONTROL = 0x11,
+	VK_MENU = 0x12, VK_ESCAPE = 0x1B, VK_SPACE = 0x20, VK_PRIOR = 0x21, VK_NEXT = 0x22,
+	VK_END = 0x23, VK_HOME = 0x24, VK_LEFT = 0x25, VK_UP = 0x26, VK_RIGHT = 0x27,
+	VK_DOWN = 0x28, VK_INSERT = 0x2D, VK_DELETE = 0x2E, VK_F1 = 0x70,
+	VK_OEM_PLUS = 0xBB, VK_OEM_MINUS = 0xBD
+};
+
+enum {
+	WM_CLOSE = 0x0010, WM_NCDESTROY = 0x0082, WM_KEYDOWN = 0x0100, WM_SYSKEYDOWN = 0x0104,
+	WM_COMMAND = 0x0111, WM_SYSCOMMAND = 0x0112, WM_INITMENUPOPUP = 0x0117,
+	WM_ENTERMENULOOP = 0x0211, WM_EXITMENULOOP = 0x0212, WM_USER = 0x0400
+};
+
+enum { SC_SCREENSAVE = 0xF140, SC_MONITORPOWER = 0xF170 };
+enum { MB_OK = 0, MB_YESNO = 4, MB_TOPMOST = 0x40000, IDOK = 1, IDYES = 6, IDNO = 7 };
+enum { MOVEFILE_REPLACE_EXISTING = 1, MOVEFILE_WRITE_THROUGH = 8 };
+
+enum : DWORD {
+	GENERIC_READ = 0x80000000, FILE_SHARE_READ = 1, OPEN_EXISTING = 3,
+	FILE_ATTRIBUTE_NORMAL = 0x80, PAGE_READONLY = 2, FILE_MAP_READ = 4
+};
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+
+union LARGE_INTEGER { long long QuadPart; };
+
+struct FILETIME { DWORD dwLowDateTime; DWORD dwHighDateTime; };
+
+struct WIN32_FILE_ATTRIBUTE_DATA {
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS { GetFileExInfoStandard };
+
+// Windows
+LONG_PTR GetWindowLongPtr(HWND hwnd, int index);
+LONG_PTR SetWindowLongPtr(HWND hwnd, int index, LONG_PTR value);
+LONG_PTR SetClassLongPtrA(HWND hwnd, int index, LONG_PTR value);
+HANDLE GetPropA(HWND hwnd, LPCSTR name);
+BOOL SetPropA(HWND hwnd, LPCSTR name, HANDLE data);
+HANDLE RemovePropA(HWND hwnd, LPCSTR name);
+BOOL IsWindow(HWND hwnd);
+LRESULT CallWindowProc(WNDPROC proc, HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+LRESULT DefWindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+LRESULT SendMessageA(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+// Messages
+UINT RegisterWindowMessageA(LPCSTR name);
+BOOL PostMessageA(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+void PostQuitMessage(int code);
+int MessageBoxA(HWND hwnd, LPCSTR text, LPCSTR caption, UINT type);
+SHORT GetKeyState(int key);
+DWORD GetCurrentThreadId();
+
+// Files
+DWORD GetModuleFileNameA(HMODULE module, LPSTR path, DWORD size);
+BOOL DeleteFileA(LPCSTR path);
+BOOL MoveFileExA(LPCSTR from, LPCSTR to, DWORD flags);
+HANDLE CreateFileA(LPCSTR path, DWORD access, DWORD share, void *security, DWORD creation, DWORD attributes, HANDLE hTemplate);
+BOOL GetFileSizeEx(HANDLE hFile, LARGE_INTEGER *size);
+HANDLE CreateFileMappingA(HANDLE hFile, void *security, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCSTR name);
+void *MapViewOfFile(HANDLE hMap, DWORD access, DWORD offsetHigh, DWORD offsetLow, size_t size);
+BOOL UnmapViewOfFile(const void *view);
+BOOL CloseHandle(HANDLE handle);
+BOOL GetFileAttributesExA(LPCSTR path, GET_FILEEX_INFO_LEVELS level, void *info);
+long CompareFileTime(const FILETIME *a, const FILETIME *b);
+
+#define sprintf_s snprintf
@@ -0,0 +1,445 @@
+//
+// Headless build - Windows functions used by ofxWinMenu
+//
+#include "headless.h"
+#include "ofxWinMenuRecorder.h"
+#include <io.h>
+#include <Shlwapi.h>
+#include <CommCtrl.h>
+#include <map>
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Menus without Windows are kept in memory
+ofxWinMenuBackend *ofxWinMenuBackend::Default()
+{
+	static ofxWinMenuRecorder recorder;
+	return &recorder;
+}
+
+//
+// Windows
+//
+
+struct headlessSubclass {
+	SUBCLASSPROC proc;
+	UINT_PTR id;
+	DWORD_PTR refData;
+};
+
+struct headlessWindow {
+	LONG_PTR proc = 0;
+	std::map<std::string, HANDLE> props;
+	LONG_PTR subclassedProc = 0; // Window procedure replaced by the first subclass
+	std::vector<headlessSubclass> subclasses; // Last is called first
+};
+
+struct headlessMessage {
+	HWND hwnd;
+	UINT msg;
+	WPARAM wParam;
+	LPARAM lParam;
+};
+
+static std::map<HWND, headlessWindow> windows;
+static uintptr_t nextWindow = 1;
+static std::mutex postedMutex;
+static std::deque<headlessMessage> postedMessages;
+static bool keyDown[256];
+static int messageBoxResult = IDOK;
+static int quitCode = -1;
+
+static headlessWindow *FindHeadlessWindow(HWND hwnd)
+{
+	auto it = windows.find(hwnd);
+	return it == windows.end() ? nullptr : &it->second;
+}
+
+HWND HeadlessCreateWindow(WNDPROC proc)
+{
+	HWND hwnd = (HWND)nextWindow++;
+	windows[hwnd].proc = (LONG_PTR)proc;
+	return hwnd;
+}
+
+void HeadlessDestroyWindow(HWND hwnd)
+{
+	if(!FindHeadlessWindow(hwnd))
+		return;
+	SendMessageA(hwnd, WM_NCDESTROY, 0, 0);
+	windows.erase(hwnd);
+}
+
+int HeadlessDispatchPosted()
+{
+	int nSent = 0;
+	for(;;) {
+		headlessMessage message;
+		{
+			std::lock_guard<std::mutex> lock(postedMutex);
+			if(postedMessages.empty())
+				break;
+			message = postedMessages.front();
+			postedMessages.pop_front();
+		}
+		SendMessageA(message.hwnd, message.msg, message.wParam, message.lParam);
+		nSent++;
+	}
+	return nSent;
+}
+
+void HeadlessSetKey(int key, bool bDown)
+{
+	keyDown[key & 0xFF] = bDown;
+}
+
+void HeadlessSetMessageBoxResult(int result)
+{
+	messageBoxResult = result;
+}
+
+int HeadlessGetQuitCode()
+{
+	return quitCode;
+}
+
+LONG_PTR GetWindowLongPtr(HWND hwnd, int index)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	return (window && index == GWLP_WNDPROC) ? window->proc : 0;
+}
+
+LONG_PTR SetWindowLongPtr(HWND hwnd, int index, LONG_PTR value)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window || index != GWLP_WNDPROC)
+		return 0;
+	LONG_PTR old = window->proc;
+	window->proc = value;
+	return old;
+}
+
+LONG_PTR SetClassLongPtrA(HWND, int, LONG_PTR)
+{
+	return 0;
+}
+
+HANDLE GetPropA(HWND hwnd, LPCSTR name)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window)
+		return NULL;
+	auto it = window->props.find(name);
+	return it == window->props.end() ? NULL : it->second;
+}
+
+BOOL SetPropA(HWND hwnd, LPCSTR name, HANDLE data)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window)
+		return FALSE;
+	window->props[name] = data;
+	return TRUE;
+}
+
+HANDLE RemovePropA(HWND hwnd, LPCSTR name)
+{
+	HANDLE data = GetPropA(hwnd, name);
+	if(data)
+		FindHeadlessWindow(hwnd)->props.erase(name);
+	return data;
+}
+
+BOOL IsWindow(HWND hwnd)
+{
+	return FindHeadlessWindow(hwnd) != nullptr;
+}
+
+LRESULT CallWindowProc(WNDPROC proc, HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	return proc ? proc(hwnd, msg, wParam, lParam) : 0;
+}
+
+LRESULT DefWindowProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+LRESULT SendMessageA(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window || !window->proc)
+		return 0;
+	return ((WNDPROC)window->proc)(hwnd, msg, wParam, lParam);
+}
+
+//
+// Window subclasses
+//
+// The first subclass replaces the window procedure with one that calls
+// the subclasses, last set first. DefSubclassProc calls the next one,
+// then the procedure replaced. The procedure is restored when the last
+// subclass is removed, unless another has been set since.
+//
+
+// Subclass being called by each thread, for DefSubclassProc
+static thread_local std::vector<std::pair<HWND, int>> subclassCalls;
+
+static LRESULT CallSubclass(HWND hwnd, int index, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window)
+		return 0;
+	if(index < 0 || index >= (int)window->subclasses.size())
+		return CallWindowProc((WNDPROC)window->subclassedProc, hwnd, msg, wParam, lParam);
+	headlessSubclass subclass = window->subclasses[index];
+	subclassCalls.push_back({ hwnd, index });
+	LRESULT result = subclass.proc(hwnd, msg, wParam, lParam, subclass.id, subclass.refData);
+	subclassCalls.pop_back();
+	return result;
+}
+
+static LRESULT CALLBACK SubclassWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window)
+		return 0;
+	return CallSubclass(hwnd, (int)window->subclasses.size() - 1, msg, wParam, lParam);
+}
+
+static int FindSubclass(headlessWindow *window, SUBCLASSPROC proc, UINT_PTR id)
+{
+	for(int i = 0; i < (int)window->subclasses.size(); i++) {
+		if(window->subclasses[i].proc == proc && window->subclasses[i].id == id)
+			return i;
+	}
+	return -1;
+}
+
+BOOL SetWindowSubclass(HWND hwnd, SUBCLASSPROC proc, UINT_PTR id, DWORD_PTR refData)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	if(!window || !proc)
+		return FALSE;
+	int index = FindSubclass(window, proc, id);
+	if(index >= 0) {
+		window->subclasses[index].refData = refData;
+		return TRUE;
+	}
+	if(window->subclasses.empty()) {
+		window->subclassedProc = window->proc;
+		window->proc = (LONG_PTR)SubclassWndProc;
+	}
+	window->subclasses.push_back({ proc, id, refData });
+	return TRUE;
+}
+
+BOOL GetWindowSubclass(HWND hwnd, SUBCLASSPROC proc, UINT_PTR id, DWORD_PTR *refData)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	int index = window ? FindSubclass(window, proc, id) : -1;
+	if(refData)
+		*refData = index < 0 ? 0 : window->subclasses[index].refData;
+	return index >= 0;
+}
+
+BOOL RemoveWindowSubclass(HWND hwnd, SUBCLASSPROC proc, UINT_PTR id)
+{
+	headlessWindow *window = FindHeadlessWindow(hwnd);
+	int index = window ? FindSubclass(window, proc, id) : -1;
+	if(index < 0)
+		return FALSE;
+	window->subclasses.erase(window->subclasses.begin() + index);
+	if(window->subclasses.empty() && window->proc == (LONG_PTR)SubclassWndProc)
+		window->proc = window->subclassedProc;
+	return TRUE;
+}
+
+LRESULT DefSubclassProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	int index = -1;
+	if(!subclassCalls.empty() && subclassCalls.back().first == hwnd)
+		index = subclassCalls.back().second - 1;
+	return CallSubclass(hwnd, index, msg, wParam, lParam);
+}
+
+//
+// Messages
+//
+
+UINT RegisterWindowMessageA(LPCSTR name)
+{
+	static std::mutex mutex;
+	static std::map<std::string, UINT> registered;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = registered.find(name);
+	if(it != registered.end())
+		return it->second;
+	UINT msg = 0xC000 + (UINT)registered.size();
+	registered[name] = msg;
+	return msg;
+}
+
+BOOL PostMessageA(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	std::lock_guard<std::mutex> lock(postedMutex);
+	postedMessages.push_back({ hwnd, msg, wParam, lParam });
+	return TRUE;
+}
+
+void PostQuitMessage(int code)
+{
+	quitCode = code;
+}
+
+int MessageBoxA(HWND, LPCSTR, LPCSTR, UINT)
+{
+	return messageBoxResult;
+}
+
+SHORT GetKeyState(int key)
+{
+	return keyDown[key & 0xFF] ? (SHORT)0x8000 : 0;
+}
+
+DWORD GetCurrentThreadId()
+{
+	return (DWORD)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+//
+// Files
+//
+
+struct headlessFile {
+	int fd;
+	size_t size;
+	bool bMapping;
+};
+
+static std::mutex viewMutex;
+static std::map<const void *, size_t> views;
+
+int _access(const char *path, int mode)
+{
+	return access(path, mode);
+}
+
+DWORD GetModuleFileNameA(HMODULE, LPSTR path, DWORD size)
+{
+	ssize_t n = readlink("/proc/self/exe", path, size - 1);
+	if(n < 0)
+		n = 0;
+	path[n] = 0;
+	return (DWORD)n;
+}
+
+BOOL PathRemoveFileSpecA(LPSTR path)
+{
+	char *last = nullptr;
+	for(char *p = path; *p; p++) {
+		if(*p == '/' || *p == '\\')
+			last = p;
+	}
+	if(!last)
+		return FALSE;
+	*last = 0;
+	return TRUE;
+}
+
+BOOL DeleteFileA(LPCSTR path)
+{
+	return unlink(path) == 0;
+}
+
+BOOL MoveFileExA(LPCSTR from, LPCSTR to, DWORD)
+{
+	return rename(from, to) == 0;
+}
+
+HANDLE CreateFileA(LPCSTR path, DWORD, DWORD, void *, DWORD, DWORD, HANDLE)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return INVALID_HANDLE_VALUE;
+	struct stat st;
+	fstat(fd, &st);
+	return new headlessFile{ fd, (size_t)st.st_size, false };
+}
+
+BOOL GetFileSizeEx(HANDLE hFile, LARGE_INTEGER *size)
+{
+	size->QuadPart = (long long)((headlessFile *)hFile)->size;
+	return TRUE;
+}
+
+HANDLE CreateFileMappingA(HANDLE hFile, void *, DWORD, DWORD, DWORD, LPCSTR)
+{
+	headlessFile *file = (headlessFile *)hFile;
+	if(file->size == 0)
+		return NULL;
+	return new headlessFile{ file->fd, file->size, true };
+}
+
+void *MapViewOfFile(HANDLE hMap, DWORD, DWORD, DWORD, size_t)
+{
+	headlessFile *map = (headlessFile *)hMap;
+	void *view = mmap(nullptr, map->size, PROT_READ, MAP_PRIVATE, map->fd, 0);
+	if(view == MAP_FAILED)
+		return nullptr;
+	std::lock_guard<std::mutex> lock(viewMutex);
+	views[view] = map->size;
+	return view;
+}
+
+BOOL UnmapViewOfFile(const void *view)
+{
+	std::lock_guard<std::mutex> lock(viewMutex);
+	auto it = views.find(view);
+	if(it == views.end())
+		return FALSE;
+	munmap((void *)view, it->second);
+	views.erase(it);
+	return TRUE;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+	headlessFile *file = (headlessFile *)handle;
+	if(!file->bMapping)
+		close(file->fd);
+	delete file;
+	return TRUE;
+}
+
+BOOL GetFileAttributesExA(LPCSTR path, GET_FILEEX_INFO_LEVELS, void *info)
+{
+	struct stat st;
+	if(stat(path, &st) != 0)
+		return FALSE;
+	WIN32_FILE_ATTRIBUTE_DATA *data = (WIN32_FILE_ATTRIBUTE_DATA *)info;
+	*data = WIN32_FILE_ATTRIBUTE_DATA{};
+	data->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	// 100 nanosecond units
+	uint64_t time = (uint64_t)st.st_mtim.tv_sec * 10000000 + (uint64_t)st.st_mtim.tv_nsec / 100;
+	data->ftLastWriteTime.dwLowDateTime = (DWORD)(time & 0xFFFFFFFF);
+	data->ftLastWriteTime.dwHighDateTime = (DWORD)(time >> 32);
+	data->nFileSizeLow = (DWORD)((uint64_t)st.st_size & 0xFFFFFFFF);
+	data->nFileSizeHigh = (DWORD)((uint64_t)st.st_size >> 32);
+	return TRUE;
+}
+
+long CompareFileTime(const FILETIME *a, const FILETIME *b)
+{
+	uint64_t ta = ((uint64_t)a->dwHighDateTime << 32) | a->dwLowDateTime;
+	uint64_t tb = ((uint64_t)b->dwHighDateTime << 32) | b->dwLowDateTime;
+	return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
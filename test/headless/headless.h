@@ -0,0 +1,24 @@
+//
+// Headless build - functions for tests in place of a window and user input
+//
+#pragma once
+
+#include <Windows.h>
+
+// Create a window with a window procedure
+HWND HeadlessCreateWindow(WNDPROC proc);
+
+// Destroy a window, which receives WM_NCDESTROY
+void HeadlessDestroyWindow(HWND hwnd);
+
+// Send messages posted by PostMessageA, returns the number sent
+int HeadlessDispatchPosted();
+
+// Key state returned by GetKeyState
+void HeadlessSetKey(int key, bool bDown);
+
+// Result returned by MessageBoxA, IDOK by default
+void HeadlessSetMessageBoxResult(int result);
+
+// Code of the last PostQuitMessage, -1 if none
+int HeadlessGetQuitCode();
@@ -0,0 +1,4 @@
+// Headless build - see Windows.h
+#pragma once
+
+int _access(const char *path, int mode);
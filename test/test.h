@@ -0,0 +1,28 @@
+//
+// Checks for the ofxWinMenu tests
+//
+#pragma once
+
+#include <cstdio>
+#include "ofxWinMenu.h"
+#include "ofxWinMenuRecorder.h"
+#include "headless.h"
+
+static int testFailures = 0;
+
+#define CHECK(x) do { \
+	if(!(x)) { \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+		testFailures++; \
+	} \
+} while(0)
+
+// Result for main
+static int TestResult()
+{
+	if(testFailures > 0)
+		printf("%d checks failed\n", testFailures);
+	else
+		printf("All checks passed\n");
+	return testFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+//
+// Keyboard accelerators parsed, shown in the item text and selected by key
+//
+#include "test.h"
+
+class ofApp {
+	public:
+		void appMenuCommand(int item, bool bChecked) {
+			nCommands++;
+			lastItem = item;
+			lastChecked = bChecked;
+		}
+		int nCommands = 0;
+		int lastItem = -1;
+		bool lastChecked = false;
+};
+
+static int nAppKeys = 0;
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT msg, WPARAM, LPARAM)
+{
+	if(msg == WM_KEYDOWN)
+		nAppKeys++;
+	return 0;
+}
+
+int main()
+{
+	const int ctrl = ofxWinMenu::keyCtrl;
+	const int shift = ofxWinMenu::keyShift;
+	const int alt = ofxWinMenu::keyAlt;
+
+	// Keys and modifiers in any case and order, with spaces
+	CHECK(ofxWinMenu::ParseAccelerator("Ctrl+I") == (ctrl | 'I'));
+	CHECK(ofxWinMenu::ParseAccelerator("ctrl + i") == (ctrl | 'I'));
+	CHECK(ofxWinMenu::ParseAccelerator("Shift+Ctrl+S") == (ctrl | shift | 'S'));
+	CHECK(ofxWinMenu::ParseAccelerator("Control+Alt+Delete") == (ctrl | alt | VK_DELETE));
+	CHECK(ofxWinMenu::ParseAccelerator("F11") == VK_F1 + 10);
+	CHECK(ofxWinMenu::ParseAccelerator("Shift+F24") == (shift | (VK_F1 + 23)));
+	CHECK(ofxWinMenu::ParseAccelerator("7") == '7');
+	CHECK(ofxWinMenu::ParseAccelerator("Space") == VK_SPACE);
+	CHECK(ofxWinMenu::ParseAccelerator("PgUp") == ofxWinMenu::ParseAccelerator("PageUp"));
+	CHECK(ofxWinMenu::ParseAccelerator("Esc") == ofxWinMenu::ParseAccelerator("Escape"));
+	CHECK(ofxWinMenu::ParseAccelerator("Ctrl++") == (ctrl | VK_OEM_PLUS));
+	CHECK(ofxWinMenu::ParseAccelerator("Ctrl+-") == (ctrl | VK_OEM_MINUS));
+
+	// Not keys
+	const char *notKeys[] = { "", "Ctrl", "Ctrl+", "Meta+A", "F0", "F25", "F1x", "AB", "Ctrl+Shift", "Space+A" };
+	for(const char *key : notKeys)
+		CHECK(ofxWinMenu::ParseAccelerator(key) == -1);
+
+	// Text of a key code is parsed to the same code
+	const char *keys[] = { "Ctrl+I", "Ctrl+Shift+S", "Alt+F4", "Space", "Enter", "Esc", "Del", "PgDn", "Ctrl++", "Shift+-", "9", "Left" };
+	for(const char *key : keys) {
+		int code = ofxWinMenu::ParseAccelerator(key);
+		CHECK(ofxWinMenu::AcceleratorText(code) == key);
+		CHECK(ofxWinMenu::ParseAccelerator(ofxWinMenu::AcceleratorText(code)) == code);
+	}
+	CHECK(ofxWinMenu::AcceleratorText(0) == "");
+
+	// Menu with accelerators
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hPopup = menu->AddPopupMenu(menu->CreateWindowMenu(), "View");
+	int info = menu->AddPopupItemID(hPopup, "Show info");
+	int full = menu->AddPopupItemID(hPopup, "Full screen", false, false);
+	int other = menu->AddPopupItemID(hPopup, "Other");
+	menu->SetWindowMenu();
+	CHECK(menu->SetItemAccelerator(info, "ctrl+i"));
+	CHECK(menu->SetItemAccelerator("Full screen", "F11"));
+	CHECK(!menu->SetItemAccelerator(other, "Ctrl+Meta"));
+	CHECK(!menu->SetItemAccelerator("Missing", "F1"));
+
+	// The key is shown in the item text
+	CHECK(recorder.GetEntry(hPopup, info, MF_BYCOMMAND)->text == "Show info\tCtrl+I");
+	CHECK(recorder.GetEntry(hPopup, full, MF_BYCOMMAND)->text == "Full screen\tF11");
+	CHECK(recorder.GetEntry(hPopup, other, MF_BYCOMMAND)->text == "Other");
+
+	// A key selects the item the same way as the menu
+	HeadlessSetKey(VK_CONTROL, true);
+	SendMessageA(hwnd, WM_KEYDOWN, 'I', 0);
+	HeadlessSetKey(VK_CONTROL, false);
+	CHECK(app.nCommands == 1 && app.lastItem == info && app.lastChecked);
+	CHECK(menu->GetPopupItem(info));
+	CHECK(recorder.GetEntry(hPopup, info, MF_BYCOMMAND)->bChecked);
+	CHECK(nAppKeys == 0);
+
+	// Repeated key messages and keys without the modifiers are passed on
+	HeadlessSetKey(VK_CONTROL, true);
+	SendMessageA(hwnd, WM_KEYDOWN, 'I', 0x40000000);
+	HeadlessSetKey(VK_CONTROL, false);
+	SendMessageA(hwnd, WM_KEYDOWN, 'I', 0);
+	CHECK(app.nCommands == 1 && nAppKeys == 2);
+
+	// A disabled item is not selected but the key is used
+	menu->EnablePopupItem(full, false);
+	SendMessageA(hwnd, WM_KEYDOWN, VK_F1 + 10, 0);
+	CHECK(app.nCommands == 1 && nAppKeys == 2);
+	menu->EnablePopupItem(full, true);
+	SendMessageA(hwnd, WM_KEYDOWN, VK_F1 + 10, 0);
+	CHECK(app.nCommands == 2 && app.lastItem == full);
+
+	// A key moved to another item is removed from the first
+	CHECK(menu->SetItemAccelerator(other, "F11"));
+	CHECK(recorder.GetEntry(hPopup, full, MF_BYCOMMAND)->text == "Full screen");
+	CHECK(recorder.GetEntry(hPopup, other, MF_BYCOMMAND)->text == "Other\tF11");
+	SendMessageA(hwnd, WM_KEYDOWN, VK_F1 + 10, 0);
+	CHECK(app.nCommands == 3 && app.lastItem == other);
+
+	// An empty key removes the accelerator
+	CHECK(menu->SetItemAccelerator(other, ""));
+	CHECK(recorder.GetEntry(hPopup, other, MF_BYCOMMAND)->text == "Other");
+	SendMessageA(hwnd, WM_KEYDOWN, VK_F1 + 10, 0);
+	CHECK(app.nCommands == 3 && nAppKeys == 3);
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
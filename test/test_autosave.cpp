@@ -0,0 +1,102 @@
+//
+// Auto save writes changed items after a quiet period
+//
+#include "test.h"
+
+class ofApp {};
+
+static const int nItems = 200;
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+static ofxWinMenu *CreateMenu(ofxWinMenuRecorder &recorder, HWND hwnd, std::vector<int> &items)
+{
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	items.clear();
+	for(int i = 0; i < nItems; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i)));
+	menu->SetWindowMenu();
+	menu->SetBinaryState(true);
+	return menu;
+}
+
+static void DeleteMenu(ofxWinMenu *menu)
+{
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+}
+
+static bool WaitForWrites(ofxWinMenu *menu, int nWrites)
+{
+	for(int n = 0; n < 400 && menu->GetAutoSaveWrites() < nWrites; n++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	return menu->GetAutoSaveWrites() >= nWrites;
+}
+
+int main()
+{
+	std::string inipath = "./test_autosave.ini";
+	std::string binpath = "./test_autosave.menu";
+	DeleteFileA(inipath.c_str());
+
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	std::vector<int> items;
+	ofxWinMenu *menu = CreateMenu(recorder, hwnd, items);
+
+	// Saved with a binary state file
+	menu->Save(inipath, true);
+	CHECK(_access(binpath.c_str(), 0) == 0);
+
+	// Many changes in a short time are saved together
+	menu->SetAutoSave(inipath, 50);
+	for(int i = 0; i < 100; i++)
+		menu->SetPopupItem(items[i], true);
+	CHECK(WaitForWrites(menu, 1));
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	CHECK(menu->GetAutoSaveWrites() <= 2);
+	CHECK(menu->GetAutoSaveWrites() + menu->GetAutoSaveCoalesced() == 100);
+
+	// The binary state file no longer matches and is deleted
+	CHECK(_access(binpath.c_str(), 0) == -1);
+
+	// Changes not yet saved are saved when the menu is deleted
+	menu->SetAutoSave(inipath, 60000);
+	menu->SetPopupItem(items[150], true);
+	DeleteMenu(menu);
+
+	// The next Load restores the saved changes
+	menu = CreateMenu(recorder, hwnd, items);
+	CHECK(menu->Load(inipath));
+	int nWrong = 0;
+	for(int i = 0; i < nItems; i++)
+		nWrong += menu->GetPopupItem(items[i]) != (i < 100 || i == 150);
+	CHECK(nWrong == 0);
+
+	// A binary state file written again by Save is deleted again by the next auto save
+	menu->Save(inipath, true);
+	CHECK(_access(binpath.c_str(), 0) == 0);
+	menu->SetAutoSave(inipath, 10);
+	menu->SetPopupItem(items[0], false);
+	CHECK(WaitForWrites(menu, 1));
+	CHECK(_access(binpath.c_str(), 0) == -1);
+	menu->StopAutoSave();
+	DeleteMenu(menu);
+
+	menu = CreateMenu(recorder, hwnd, items);
+	CHECK(menu->Load(inipath));
+	CHECK(!menu->GetPopupItem(items[0]));
+	CHECK(menu->GetPopupItem(items[1]));
+
+	DeleteFileA(inipath.c_str());
+	DeleteFileA(binpath.c_str());
+	DeleteMenu(menu);
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,107 @@
+//
+// Menus shown by the backend match the item model
+//
+#include "test.h"
+
+class ofApp {
+	public:
+		void appMenuFunction(std::string title, bool bChecked) {
+			lastTitle = title;
+			lastChecked = bChecked;
+		}
+		std::string lastTitle;
+		bool lastChecked = false;
+};
+
+int main()
+{
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuFunction);
+
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hFile = menu->AddPopupMenu(hMenu, "File");
+	HMENU hView = menu->AddPopupMenu(hMenu, "View");
+	CHECK(hMenu && hFile && hView);
+	CHECK(recorder.GetItemCount(hMenu) == 2);
+
+	int open = menu->AddPopupItemID(hFile, "Open", false, false);
+	menu->AddPopupSeparator(hFile);
+	int exit = menu->AddPopupItemID(hFile, "Exit", false, false);
+	int info = menu->AddPopupItemID(hView, "Show info", true);
+	CHECK(recorder.GetItemCount(hFile) == 3);
+	CHECK(recorder.GetPosition(hFile, exit) == 2);
+	CHECK(recorder.GetEntry(hFile, 1, MF_BYPOSITION)->bSeparator);
+	CHECK(recorder.GetEntry(hFile, 0, MF_BYPOSITION)->text == "Open");
+	CHECK(recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+
+	CHECK(menu->SetWindowMenu());
+	CHECK(recorder.GetWindowMenu(hwnd) == hMenu);
+
+	// Item changes are shown
+	CHECK(menu->SetPopupItem("Show info", false));
+	CHECK(!recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+	CHECK(menu->EnablePopupItem(open, false));
+	CHECK(!recorder.GetEntry(hFile, open, MF_BYCOMMAND)->bEnabled);
+
+	// Changes in an update are shown once by EndUpdate
+	recorder.ResetCalls();
+	menu->BeginUpdate();
+	for(int i = 0; i < 10; i++)
+		menu->SetPopupItem(info, i % 2 == 1);
+	menu->EnablePopupItem(open, true);
+	CHECK(recorder.GetCalls() == 0);
+	CHECK(menu->EndUpdate());
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_CHECK) == 1);
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_ENABLE) == 1);
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_DRAW_MENU_BAR) == 1);
+	CHECK(recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+	CHECK(recorder.GetEntry(hFile, open, MF_BYCOMMAND)->bEnabled);
+	CHECK(menu->GetUpdateSaved() == 9);
+
+	// Changes are kept if the menu is not valid when the update ends
+	recorder.ResetCalls();
+	menu->BeginUpdate();
+	menu->SetPopupItem(info, false);
+	menu->g_hMenu = NULL;
+	CHECK(!menu->EndUpdate());
+	menu->g_hMenu = hMenu;
+	CHECK(recorder.GetCalls() == 0);
+	CHECK(recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+	menu->BeginUpdate();
+	CHECK(menu->EndUpdate());
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_CHECK) == 1);
+	CHECK(!recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+	CHECK(menu->GetUpdateSaved() == 9);
+	menu->SetPopupItem(info, true);
+
+	// Selection by WM_COMMAND returns the item to ofApp
+	SendMessageA(hwnd, WM_COMMAND, info, 0);
+	CHECK(app.lastTitle == "Show info");
+	CHECK(!app.lastChecked);
+	CHECK(!recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+
+	// Removed items are deleted from the menu
+	CHECK(menu->RemovePopupItem(open));
+	CHECK(recorder.GetItemCount(hFile) == 2);
+	CHECK(recorder.GetPosition(hFile, exit) == 1);
+
+	// Context menus
+	HMENU hContext = menu->CreateContextMenu();
+	CHECK(menu->AddContextItem(hContext, info));
+	CHECK(menu->ShowContextMenu(hContext));
+	CHECK(recorder.trackedMenu == hContext);
+	menu->SetPopupItem(info, true);
+	CHECK(recorder.GetEntry(hContext, info, MF_BYCOMMAND)->bChecked);
+
+	CHECK(menu->RemoveWindowMenu());
+	CHECK(recorder.GetWindowMenu(hwnd) == NULL);
+	CHECK(menu->DestroyWindowMenu());
+	CHECK(!recorder.IsMenuHandle(hFile));
+
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
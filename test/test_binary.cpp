@@ -0,0 +1,158 @@
+//
+// Binary state file saved and loaded with the initialization file
+//
+#include "test.h"
+#include <sys/stat.h>
+#include <utime.h>
+
+class ofApp {};
+
+// A radio group cannot be given as an item number
+template<typename T, typename = void>
+struct isItemNumber : std::false_type {};
+template<typename T>
+struct isItemNumber<T, std::void_t<decltype(std::declval<ofxWinMenu &>().SetPopupItem(std::declval<T>(), true))>> : std::true_type {};
+static_assert(isItemNumber<int>::value, "int");
+static_assert(!isItemNumber<ofxWinMenuGroup>::value, "ofxWinMenuGroup");
+
+// Set the time a file was last written, seconds from now
+static void SetFileAge(const std::string &path, int seconds)
+{
+	struct utimbuf times;
+	times.actime = times.modtime = time(nullptr) + seconds;
+	utime(path.c_str(), &times);
+}
+
+int main()
+{
+	const int nItems = 3000;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	std::vector<int> items;
+	for(int i = 0; i < nItems; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i), i % 3 == 0, i % 11 != 0));
+	ofxWinMenuGroup group = menu->AddRadioGroup("Mode");
+	int modeA = menu->AddRadioItem(hPopup, group, "Mode A", true);
+	int modeB = menu->AddRadioItem(hPopup, group, "Mode B");
+	menu->SetWindowMenu();
+	menu->SetBinaryState(true);
+
+	std::string inipath = "./test_binary.ini";
+	std::string binpath = menu->GetBinaryPath(inipath);
+	CHECK(binpath == "./test_binary.menu");
+
+	// Round trip of auto check items
+	menu->SelectRadioItem(modeB);
+	menu->Save(inipath, true);
+	CHECK(_access(binpath.c_str(), 0) == 0);
+	auto Invert = [&]() {
+		for(int i = 0; i < nItems; i++) {
+			if(i % 11 != 0)
+				menu->SetPopupItem(items[i], !menu->GetPopupItem(items[i]));
+		}
+		menu->SelectRadioItem(modeA);
+	};
+	auto Restored = [&]() {
+		int nWrong = 0;
+		for(int i = 0; i < nItems; i++) {
+			bool bChecked = (i % 3 == 0);
+			nWrong += menu->GetPopupItem(items[i]) != bChecked;
+			// Items without auto check are not shown checked when added
+			if(i % 11 != 0)
+				nWrong += recorder.GetEntry(hPopup, items[i], MF_BYCOMMAND)->bChecked != bChecked;
+		}
+		return nWrong == 0 && menu->GetRadioItem(group) == modeB;
+	};
+	Invert();
+	CHECK(menu->LoadBinary(binpath));
+	CHECK(Restored());
+	Invert();
+	CHECK(menu->Load(inipath));
+	CHECK(Restored());
+
+	// Enabled states are not restored, the same as the initialization file
+	menu->EnablePopupItem(items[1], false);
+	menu->Save(inipath, true);
+	menu->EnablePopupItem(items[1], true);
+	CHECK(menu->LoadBinary(binpath));
+	CHECK(recorder.GetEntry(hPopup, items[1], MF_BYCOMMAND)->bEnabled);
+
+	// The binary file is used while it is not older than the initialization file.
+	// Shown by an initialization file with different states.
+	std::string iniText;
+	{
+		std::ifstream infile(inipath, std::ios::binary);
+		iniText.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+	}
+	Invert();
+	menu->Save(inipath, true); // Inverted states in both files
+	{
+		std::ofstream outfile(inipath, std::ios::binary | std::ios::trunc);
+		outfile << iniText; // Saved states
+	}
+	SetFileAge(inipath, -10);
+	SetFileAge(binpath, 0);
+	Invert();
+	CHECK(menu->Load(inipath));
+	CHECK(menu->GetPopupItem(items[1])); // Inverted states from the binary file
+	CHECK(menu->GetRadioItem(group) == modeA);
+
+	// A later initialization file is loaded instead
+	SetFileAge(binpath, -20);
+	CHECK(menu->Load(inipath));
+	CHECK(Restored());
+
+	// Fall back to the initialization file if the binary file does not match
+	menu->Save(inipath, true);
+	Invert();
+	std::string data;
+	{
+		std::ifstream infile(binpath, std::ios::binary);
+		data.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+	}
+	std::string damaged = data;
+	damaged[damaged.size() - 1] ^= 1;
+	{
+		std::ofstream outfile(binpath, std::ios::binary | std::ios::trunc);
+		outfile << damaged;
+	}
+	CHECK(!menu->LoadBinary(binpath));
+	SetFileAge(inipath, -10);
+	CHECK(menu->Load(inipath));
+	CHECK(Restored());
+
+	// The binary file alone
+	DeleteFileA(inipath.c_str());
+	DeleteFileA(binpath.c_str());
+	menu->SetBinaryState(true, true);
+	CHECK(menu->GetSavePath(inipath) == binpath);
+	menu->Save(inipath, true);
+	CHECK(_access(binpath.c_str(), 0) == 0);
+	CHECK(_access(inipath.c_str(), 0) == -1);
+	Invert();
+	CHECK(menu->Load(inipath));
+	CHECK(Restored());
+	CHECK(menu->SaveAsync(inipath, true).get());
+	CHECK(_access(inipath.c_str(), 0) == -1);
+	menu->SetBinaryState(true);
+	CHECK(menu->GetSavePath(inipath) == inipath);
+
+	// A different menu does not match
+	{
+		std::ofstream outfile(binpath, std::ios::binary | std::ios::trunc);
+		outfile << data;
+	}
+	CHECK(menu->LoadBinary(binpath));
+	menu->AddPopupItemID(hPopup, "Another item");
+	CHECK(!menu->LoadBinary(binpath));
+	CHECK(!menu->LoadBinary("./test_binary_missing.menu"));
+
+	DeleteFileA(inipath.c_str());
+	DeleteFileA(binpath.c_str());
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
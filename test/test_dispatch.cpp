@@ -0,0 +1,123 @@
+//
+// Selection of a menu item by WM_COMMAND does not allocate memory
+//
+#include "test.h"
+#include <new>
+
+// The replacement operator delete is not a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<size_t> nAllocations(0);
+
+void *operator new(size_t size)
+{
+	nAllocations++;
+	void *p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+class ofApp {
+	public:
+		void appMenuView(std::string_view title, bool bChecked) {
+			nViews++;
+			lastLength = title.size();
+			lastChecked = bChecked;
+		}
+		void appMenuCommand(int item, bool bChecked) {
+			nCommands++;
+			lastItem = item;
+			lastChecked = bChecked;
+		}
+		int nViews = 0;
+		int nCommands = 0;
+		size_t lastLength = 0;
+		int lastItem = -1;
+		bool lastChecked = false;
+};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+// Allocations for a number of selections of each item
+static size_t Select(HWND hwnd, const std::vector<int> &items, int nTimes)
+{
+	size_t before = nAllocations.load();
+	for(int n = 0; n < nTimes; n++) {
+		for(int item : items)
+			SendMessageA(hwnd, WM_COMMAND, item, 0);
+	}
+	return nAllocations.load() - before;
+}
+
+int main()
+{
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	std::vector<int> items;
+	for(int i = 0; i < 100; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "A long item name that is not a short string " + std::to_string(i), false, i % 2 == 0));
+	menu->SetWindowMenu();
+
+	// Title as a string view
+	menu->CreateMenuFunction(&ofApp::appMenuView);
+	Select(hwnd, items, 1);
+	CHECK(Select(hwnd, items, 100) == 0);
+	CHECK(app.nViews == 100 * 101);
+	CHECK(app.lastLength == menu->itemNames[items.back()].size());
+	CHECK(recorder.GetEntry(hPopup, items[0], MF_BYCOMMAND)->bChecked == menu->GetPopupItem(items[0]));
+
+	// Item number
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	Select(hwnd, items, 1);
+	CHECK(Select(hwnd, items, 100) == 0);
+	CHECK(app.nCommands == 100 * 101);
+	CHECK(app.lastItem == items.back());
+
+	// Item functions
+	int nCalls = 0;
+	for(int item : items)
+		menu->SetItemFunction(item, [&nCalls](bool) { nCalls++; });
+	Select(hwnd, items, 1);
+	CHECK(Select(hwnd, items, 100) == 0);
+	CHECK(nCalls == 100 * 101);
+
+	// Accelerator keys
+	menu->SetItemAccelerator(items[0], "Ctrl+K");
+	HeadlessSetKey(VK_CONTROL, true);
+	SendMessageA(hwnd, WM_KEYDOWN, 'K', 0);
+	size_t before = nAllocations.load();
+	for(int n = 0; n < 1000; n++)
+		SendMessageA(hwnd, WM_KEYDOWN, 'K', 0);
+	CHECK(nAllocations.load() - before == 0);
+	HeadlessSetKey(VK_CONTROL, false);
+	CHECK(nCalls == 100 * 101 + 1001);
+
+	// Command IDs that are not items
+	before = nAllocations.load();
+	SendMessageA(hwnd, WM_COMMAND, 0x7FFF, 0);
+	CHECK(nAllocations.load() - before == 0);
+
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,132 @@
+//
+// Load reads the file once and changes the menu in one update
+//
+#include "test.h"
+
+class ofApp {
+	public:
+		void appMenuCommand(int item, bool bChecked) {
+			calls.push_back({ item, bChecked });
+		}
+		std::vector<std::pair<int, bool>> calls;
+};
+
+int main()
+{
+	const int nItems = 1000;
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	std::vector<int> items;
+	for(int i = 0; i < nItems; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i), i % 2 == 0));
+	ofxWinMenuGroup group = menu->AddRadioGroup("Quality");
+	int low = menu->AddRadioItem(hPopup, group, "Low", true);
+	int high = menu->AddRadioItem(hPopup, group, "High");
+	menu->SetWindowMenu();
+
+	std::string inipath = "./test_ini_load.ini";
+	{
+		// Keys in any case, with spaces, other sections and unknown keys
+		std::ofstream outfile(inipath, std::ios::binary);
+		outfile << "[Graphics]\r\nItem 1=1\r\n[MENU]\r\n";
+		for(int i = 0; i < nItems; i++) {
+			bool bChecked = (i % 2 == 0) != (i % 10 == 0); // Every tenth item changes
+			outfile << (i % 3 == 0 ? "ITEM " : "Item ") << i << " = " << (bChecked ? 1 : 0) << "\r\n";
+		}
+		outfile << "Unknown=1\r\nQuality=High\r\n";
+	}
+
+	// Only changed items change the menu and are returned to ofApp
+	recorder.ResetCalls();
+	CHECK(menu->Load(inipath));
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_CHECK) == nItems / 10 + 2);
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_DRAW_MENU_BAR) == 1);
+	CHECK(app.calls.size() == nItems / 10 + 1);
+	int nWrong = 0;
+	for(int i = 0; i < nItems; i++) {
+		bool bChecked = (i % 2 == 0) != (i % 10 == 0);
+		nWrong += menu->GetPopupItem(items[i]) != bChecked;
+		nWrong += recorder.GetEntry(hPopup, items[i], MF_BYCOMMAND)->bChecked != bChecked;
+	}
+	CHECK(nWrong == 0);
+	for(auto &call : app.calls) {
+		if(call.first != high)
+			CHECK(call.first % 10 == 0 && call.second == menu->GetPopupItem(call.first));
+	}
+	CHECK(menu->GetRadioItem(group) == high);
+	CHECK(!recorder.GetEntry(hPopup, low, MF_BYCOMMAND)->bChecked);
+	CHECK(recorder.GetEntry(hPopup, high, MF_BYCOMMAND)->bChecked);
+
+	// Loading again changes nothing
+	app.calls.clear();
+	recorder.ResetCalls();
+	CHECK(menu->Load(inipath));
+	CHECK(app.calls.empty());
+	CHECK(recorder.GetCalls(ofxWinMenuRecorder::CALL_CHECK) == 0);
+
+	// Save and Load return the same states
+	menu->Save(inipath, true);
+	for(int i = 0; i < nItems; i += 5)
+		menu->SetPopupItem(items[i], !menu->GetPopupItem(items[i]));
+	menu->SelectRadioItem(low);
+	app.calls.clear();
+	CHECK(menu->Load(inipath));
+	CHECK(app.calls.size() == nItems / 5 + 1);
+	CHECK(menu->GetRadioItem(group) == high);
+	nWrong = 0;
+	for(int i = 0; i < nItems; i++)
+		nWrong += menu->GetPopupItem(items[i]) != ((i % 2 == 0) != (i % 10 == 0));
+	CHECK(nWrong == 0);
+
+	// Radio groups with items of the same name
+	ofxWinMenuGroup blend = menu->AddRadioGroup("Blend");
+	int blendNone = menu->AddRadioItem(hPopup, blend, "None", true);
+	int blendAdd = menu->AddRadioItem(hPopup, blend, "Add");
+	ofxWinMenuGroup filter = menu->AddRadioGroup("Filter");
+	int filterNone = menu->AddRadioItem(hPopup, filter, "None");
+	int filterBlur = menu->AddRadioItem(hPopup, filter, "Blur", true);
+	std::string groupspath = "./test_ini_load_groups.ini";
+	{
+		std::ofstream outfile(groupspath, std::ios::binary);
+		outfile << "[Menu]\r\nBlend=Add\r\nFilter=None\r\n";
+	}
+	CHECK(menu->Load(groupspath));
+	CHECK(menu->GetRadioItem(blend) == blendAdd);
+	CHECK(menu->GetRadioItem(filter) == filterNone);
+	CHECK(!recorder.GetEntry(hPopup, blendNone, MF_BYCOMMAND)->bChecked);
+	CHECK(recorder.GetEntry(hPopup, filterNone, MF_BYCOMMAND)->bChecked);
+
+	// The same with the file written by Save and by auto save
+	menu->SelectRadioItem(blendNone);
+	menu->SelectRadioItem(filterBlur);
+	menu->Save(groupspath, true);
+	menu->SelectRadioItem(blendAdd);
+	menu->SelectRadioItem(filterNone);
+	CHECK(menu->Load(groupspath));
+	CHECK(menu->GetRadioItem(blend) == blendNone);
+	CHECK(menu->GetRadioItem(filter) == filterBlur);
+	menu->SetAutoSave(groupspath, 10);
+	menu->SelectRadioItem(blendAdd);
+	menu->SelectRadioItem(filterNone);
+	menu->StopAutoSave();
+	menu->SelectRadioItem(blendNone);
+	menu->SelectRadioItem(filterBlur);
+	CHECK(menu->Load(groupspath));
+	CHECK(menu->GetRadioItem(blend) == blendAdd);
+	CHECK(menu->GetRadioItem(filter) == filterNone);
+	DeleteFileA(groupspath.c_str());
+
+	// Files that cannot be loaded
+	CHECK(!menu->Load("./test_ini_load_missing.ini"));
+	CHECK(!menu->Load("./test_ini_load.txt"));
+
+	DeleteFileA(inipath.c_str());
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
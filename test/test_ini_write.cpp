@@ -0,0 +1,119 @@
+//
+// Save writes the menu section once and keeps the other sections
+//
+#include "test.h"
+
+class ofApp {};
+
+static std::string ReadFile(const std::string &path)
+{
+	std::ifstream infile(path, std::ios::binary);
+	return std::string((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+	// Keys replaced in place, new keys at the end of the section
+	std::string text =
+		"; Settings\r\n"
+		"[Graphics]\r\n"
+		"width=640\r\n"
+		"\r\n"
+		"[menu]\r\n"
+		"show INFO=0\r\n"
+		"; comment\r\n"
+		"Old=1\r\n"
+		"\r\n"
+		"[Audio]\r\n"
+		"volume=5\r\n";
+	std::string merged = ofxWinMenu::MergeIniSection(text, "Menu", { { "Show info", "1" }, { "New", "0" } });
+	CHECK(merged ==
+		"; Settings\r\n"
+		"[Graphics]\r\n"
+		"width=640\r\n"
+		"\r\n"
+		"[menu]\r\n"
+		"Show info=1\r\n"
+		"; comment\r\n"
+		"Old=1\r\n"
+		"New=0\r\n"
+		"\r\n"
+		"[Audio]\r\n"
+		"volume=5\r\n");
+
+	// A section that does not exist is added at the end
+	merged = ofxWinMenu::MergeIniSection("[Graphics]\nwidth=640\n", "Menu", { { "A", "1" } });
+	CHECK(merged == "[Graphics]\r\nwidth=640\r\n[Menu]\r\nA=1\r\n");
+	CHECK(ofxWinMenu::MergeIniSection("", "Menu", {}) == "[Menu]\r\n");
+
+	// Merging again does not change the text
+	CHECK(ofxWinMenu::MergeIniSection(merged, "Menu", { { "a", "1" } }) == "[Graphics]\r\nwidth=640\r\n[Menu]\r\na=1\r\n");
+
+	std::unordered_map<std::string, std::string> keys;
+	ofxWinMenu::ParseIniSection(text, "MENU", keys);
+	CHECK(keys.size() == 2 && keys["show info"] == "0" && keys["old"] == "1");
+
+	// Save of a large menu to a file with another section
+	const int nItems = 10000;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	for(int i = 0; i < nItems; i++)
+		menu->AddPopupItem(hPopup, "Item " + std::to_string(i), i % 3 == 0, i % 7 != 0);
+	menu->AddPopupSeparator(hPopup);
+
+	std::string inipath = "./test_ini_write.ini";
+	DeleteFileA(inipath.c_str());
+	{
+		std::ofstream outfile(inipath, std::ios::binary);
+		outfile << "[Graphics]\r\nwidth=640\r\nheight=480\r\n";
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	menu->Save(inipath, true);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("Save of %d items %.2f ms\n", nItems, ms);
+
+	CHECK(_access((inipath + ".tmp").c_str(), 0) == -1);
+	std::string saved = ReadFile(inipath);
+	CHECK(saved.rfind("[Graphics]\r\nwidth=640\r\nheight=480\r\n[Menu]\r\nItem 1=0\r\n", 0) == 0);
+
+	keys.clear();
+	CHECK(ofxWinMenu::ReadIniSection(inipath, "Menu", keys));
+	int nWrong = 0;
+	for(int i = 0; i < nItems; i++) {
+		auto it = keys.find("item " + std::to_string(i));
+		// Only auto check items are saved
+		if(i % 7 == 0)
+			nWrong += it != keys.end();
+		else
+			nWrong += it == keys.end() || it->second != (i % 3 == 0 ? "1" : "0");
+	}
+	CHECK(nWrong == 0);
+	keys.clear();
+	CHECK(ofxWinMenu::ReadIniSection(inipath, "Graphics", keys));
+	CHECK(keys.size() == 2 && keys["height"] == "480");
+
+	// Saving again replaces the keys
+	menu->SetPopupItem("Item 1", true);
+	menu->Save(inipath, true);
+	std::string again = ReadFile(inipath);
+	CHECK(again.size() == saved.size());
+	keys.clear();
+	ofxWinMenu::ParseIniSection(again, "Menu", keys);
+	CHECK(keys["item 1"] == "1");
+
+	// A file that exists is not replaced without confirmation
+	HeadlessSetMessageBoxResult(IDNO);
+	menu->SetPopupItem("Item 1", false);
+	menu->Save(inipath, false);
+	CHECK(ReadFile(inipath) == again);
+	HeadlessSetMessageBoxResult(IDOK);
+
+	DeleteFileA(inipath.c_str());
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
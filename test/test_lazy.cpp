@@ -0,0 +1,81 @@
+//
+// Lazy popup menus and the command IDs reserved for their items
+//
+#include "test.h"
+
+class ofApp {};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+int main()
+{
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+
+	// Without lazy popup menus all 16 bit command IDs are item numbers
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	menu->SetWindowMenu();
+	int nAdded = 0;
+	for(int i = 0; i < 0x10000; i++)
+		nAdded += menu->AddPopupItemID(hPopup, "Item " + std::to_string(i)) == i;
+	CHECK(nAdded == 0x10000);
+	CHECK(menu->AddPopupItemID(hPopup, "One more") == -1);
+	CHECK(!menu->AddPopupItem(hPopup, "One more"));
+	CHECK(menu->FindItem("One more") == -1);
+
+	// No command IDs are left for a lazy popup menu
+	auto provider = [](std::vector<std::string> &items) {
+		for(int i = 0; i < 10; i++)
+			items.push_back("Recent " + std::to_string(i));
+	};
+	int lastIndex = -1;
+	auto function = [&](int index, const std::string &) { lastIndex = index; };
+	CHECK(menu->AddLazyPopupMenu(hMenu, "Recent", provider, function) == NULL);
+	CHECK(recorder.GetItemCount(hMenu) == 1);
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+
+	// Lazy popup menus reserve command IDs from the top of the range
+	menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	hMenu = menu->CreateWindowMenu();
+	hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	HMENU hRecent = menu->AddLazyPopupMenu(hMenu, "Recent", provider, function, 100);
+	HMENU hPresets = menu->AddLazyPopupMenu(hMenu, "Presets", provider, function);
+	CHECK(hRecent && hPresets);
+	menu->SetWindowMenu();
+	SendMessageA(hwnd, WM_INITMENUPOPUP, (WPARAM)hRecent, 0);
+	SendMessageA(hwnd, WM_INITMENUPOPUP, (WPARAM)hPresets, 0);
+	CHECK(recorder.GetItemCount(hRecent) == 10);
+	CHECK(recorder.GetEntry(hRecent, 0, MF_BYPOSITION)->id == 0x10000 - 100);
+	CHECK(recorder.GetEntry(hPresets, 0, MF_BYPOSITION)->id == 0x10000 - 100 - 4096);
+
+	// Items are added up to the lowest reserved command ID
+	int limit = 0x10000 - 100 - 4096;
+	nAdded = 0;
+	for(int i = 0; i < limit; i++)
+		nAdded += menu->AddPopupItemID(hPopup, "Item " + std::to_string(i)) == i;
+	CHECK(nAdded == limit);
+	CHECK(menu->AddPopupItemID(hPopup, "One more") == -1);
+
+	// Selection of items and lazy menu items
+	SendMessageA(hwnd, WM_COMMAND, 0x10000 - 100 + 3, 0);
+	CHECK(lastIndex == 3);
+	SendMessageA(hwnd, WM_COMMAND, limit + 9, 0);
+	CHECK(lastIndex == 9);
+	SendMessageA(hwnd, WM_COMMAND, limit + 10, 0); // Not a lazy menu item
+	CHECK(lastIndex == 9);
+	SendMessageA(hwnd, WM_COMMAND, limit - 1, 0);
+	CHECK(menu->GetPopupItem(limit - 1));
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,99 @@
+//
+// Menu created from a constant definition with item numbers known at compile time
+//
+#include "test.h"
+
+static constexpr ofxWinMenuDef appMenu[] = {
+	{ OFXMENU_POPUP, "File" },
+		{ OFXMENU_ITEM, "Open", false, false },
+		{ OFXMENU_SEPARATOR },
+		{ OFXMENU_ITEM, "Exit", false, false },
+	{ OFXMENU_END },
+	{ OFXMENU_POPUP, "View" },
+		{ OFXMENU_ITEM, "Show info", true },
+		{ OFXMENU_POPUP, "Size" },
+			{ OFXMENU_ITEM, "Large" },
+		{ OFXMENU_END },
+		{ OFXMENU_ITEM, "Full screen", false, false, false },
+	{ OFXMENU_END },
+};
+
+// Found by the compiler
+static_assert(ofxWinMenuID(appMenu, "Open") == 0, "Open");
+static_assert(ofxWinMenuID(appMenu, "Exit") == 2, "Exit");
+static_assert(ofxWinMenuID(appMenu, "Show info") == 3, "Show info");
+static_assert(ofxWinMenuID(appMenu, "Large") == 4, "Large");
+static_assert(ofxWinMenuID(appMenu, "Full screen") == 5, "Full screen");
+static_assert(OFXWINMENU_ID(appMenu, "Exit") == 2, "Exit");
+
+class ofApp {
+	public:
+		void appMenuCommand(int item, bool bChecked) {
+			switch(item) {
+				case ofxWinMenuID(appMenu, "Open") : nOpen++; break;
+				case ofxWinMenuID(appMenu, "Exit") : nExit++; break;
+				case ofxWinMenuID(appMenu, "Show info") : bShowInfo = bChecked; break;
+				case ofxWinMenuID(appMenu, "Large") : bLarge = bChecked; break;
+				default : nOther++; break;
+			}
+		}
+		int nOpen = 0;
+		int nExit = 0;
+		int nOther = 0;
+		bool bShowInfo = false;
+		bool bLarge = false;
+};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+int main()
+{
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	CHECK(menu->CreateMenuFromDef(appMenu));
+	menu->SetWindowMenu();
+
+	// The item numbers found at compile time are the items of the menu
+	const char *names[] = { "Open", "Exit", "Show info", "Large", "Full screen" };
+	const int ids[] = {
+		ofxWinMenuID(appMenu, "Open"), ofxWinMenuID(appMenu, "Exit"), ofxWinMenuID(appMenu, "Show info"),
+		ofxWinMenuID(appMenu, "Large"), ofxWinMenuID(appMenu, "Full screen") };
+	for(int i = 0; i < 5; i++)
+		CHECK(menu->FindItem(names[i]) == ids[i]);
+	int info = OFXWINMENU_ID(appMenu, "Show info");
+	CHECK(info == ids[2]);
+
+	// Initial states from the definition
+	HMENU hFile = (HMENU)recorder.GetEntry(menu->g_hMenu, 0, MF_BYPOSITION)->id;
+	HMENU hView = (HMENU)recorder.GetEntry(menu->g_hMenu, 1, MF_BYPOSITION)->id;
+	CHECK(recorder.GetItemCount(hFile) == 3);
+	CHECK(recorder.GetEntry(hFile, 1, MF_BYPOSITION)->bSeparator);
+	CHECK(recorder.GetItemCount(hView) == 3);
+	CHECK(menu->GetPopupItem(ids[2]));
+	CHECK(recorder.GetEntry(hView, ids[2], MF_BYCOMMAND)->bChecked);
+	CHECK(!recorder.GetEntry(hView, ids[4], MF_BYCOMMAND)->bEnabled);
+
+	// Selection by WM_COMMAND reaches the case of the item
+	SendMessageA(hwnd, WM_COMMAND, ids[0], 0);
+	SendMessageA(hwnd, WM_COMMAND, ids[1], 0);
+	SendMessageA(hwnd, WM_COMMAND, ids[2], 0);
+	SendMessageA(hwnd, WM_COMMAND, ids[3], 0);
+	CHECK(app.nOpen == 1 && app.nExit == 1 && app.nOther == 0);
+	CHECK(!app.bShowInfo && !menu->GetPopupItem(ids[2]));
+	CHECK(app.bLarge && menu->GetPopupItem(ids[3]));
+
+	// A definition is only used for an empty menu
+	CHECK(!menu->CreateMenuFromDef(appMenu));
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,82 @@
+//
+// Menu created from a text description
+//
+#include "test.h"
+
+class ofApp {};
+
+// Recorder that fails to insert an entry after a number of entries
+class FailingRecorder : public ofxWinMenuRecorder {
+	public:
+		int nInserts = -1; // Entries inserted before the failure, -1 for none
+		bool InsertItem(HMENU hMenu, UINT position, UINT flags, UINT_PTR id, const char *text) {
+			if(nInserts == 0)
+				return false;
+			if(nInserts > 0)
+				nInserts--;
+			return ofxWinMenuRecorder::InsertItem(hMenu, position, flags, id, text);
+		}
+};
+
+int main()
+{
+	FailingRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+
+	// Options are whole words in any case, separated by spaces or tabs
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	CHECK(menu->CreateMenuFromText(
+		"View {\n"
+		"  Show info | checked\n"
+		"  Full screen | noauto\tDISABLED\n"
+		"  Plain |\n"
+		"  -\n"
+		"  Extra | disabled  checked \n"
+		"}\n"));
+	HMENU hPopup = (HMENU)recorder.GetEntry(menu->g_hMenu, 0, MF_BYPOSITION)->id;
+	int info = menu->FindItem("Show info");
+	int full = menu->FindItem("Full screen");
+	int plain = menu->FindItem("Plain");
+	int extra = menu->FindItem("Extra");
+	CHECK(info >= 0 && full >= 0 && plain >= 0 && extra >= 0);
+	CHECK(menu->GetPopupItem(info));
+	CHECK(recorder.GetEntry(hPopup, info, MF_BYCOMMAND)->bChecked);
+	CHECK(recorder.GetEntry(hPopup, info, MF_BYCOMMAND)->bEnabled);
+	CHECK(!recorder.GetEntry(hPopup, full, MF_BYCOMMAND)->bEnabled);
+	CHECK(!menu->GetPopupItem(plain));
+	CHECK(recorder.GetEntry(hPopup, plain, MF_BYCOMMAND)->bEnabled);
+	CHECK(recorder.GetEntry(hPopup, extra, MF_BYCOMMAND)->bChecked);
+	CHECK(!recorder.GetEntry(hPopup, extra, MF_BYCOMMAND)->bEnabled);
+	menu->DestroyWindowMenu();
+	delete menu;
+
+	// Words that contain an option are not options
+	const char *unknown[] = { "unchecked", "autocheck", "disabledx", "checked,noauto", "check" };
+	for(const char *option : unknown) {
+		menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+		CHECK(!menu->CreateMenuFromText(std::string("File {\n  Item | ") + option + "\n}\n"));
+		CHECK(menu->FindItem("Item") == -1);
+		menu->DestroyWindowMenu();
+		delete menu;
+	}
+
+	// An entry that cannot be inserted is not kept as an item
+	for(int nInserts = 0; nInserts < 3; nInserts++) {
+		menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+		recorder.nInserts = nInserts + 1; // After the popup menu
+		CHECK(!menu->CreateMenuFromText("File {\n  Open\n  -\n  Exit\n}\n"));
+		recorder.nInserts = -1;
+		const char *names[] = { "Open", "", "Exit" };
+		for(int i = 0; i < 3; i++) {
+			if(names[i][0])
+				CHECK((menu->FindItem(names[i]) >= 0) == (i < nInserts));
+		}
+		HMENU hFile = (HMENU)recorder.GetEntry(menu->g_hMenu, 0, MF_BYPOSITION)->id;
+		CHECK(recorder.GetItemCount(hFile) == nInserts);
+		menu->DestroyWindowMenu();
+		delete menu;
+	}
+
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
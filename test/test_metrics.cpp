@@ -0,0 +1,64 @@
+//
+// Command metrics recorded by the addon built with OFXWINMENU_METRICS
+// and read by an application built without it
+//
+#include "test.h"
+
+#ifdef OFXWINMENU_METRICS
+#error The application is compiled without OFXWINMENU_METRICS
+#endif
+
+class ofApp {
+	public:
+		void appMenuCommand(int, bool) {
+			nCommands++;
+		}
+		int nCommands = 0;
+};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+int main()
+{
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hPopup = menu->AddPopupMenu(menu->CreateWindowMenu(), "Popup");
+	int a = menu->AddPopupItemID(hPopup, "A");
+	int b = menu->AddPopupItemID(hPopup, "B");
+	menu->SetWindowMenu();
+
+	// Members after the metrics are where the addon put them
+	CHECK(menu->pApp == &app);
+	CHECK(menu->g_hwnd == hwnd);
+
+	for(int n = 0; n < 100; n++)
+		SendMessageA(hwnd, WM_COMMAND, a, 0);
+	SendMessageA(hwnd, WM_COMMAND, b, 0);
+	SendMessageA(hwnd, WM_COMMAND, 999, 0); // Not an item
+	CHECK(app.nCommands == 101);
+	CHECK(menu->GetCommandCount(a) == 100);
+	CHECK(menu->GetCommandCount(b) == 1);
+	CHECK(menu->GetCommandCount(999) == 0);
+	CHECK(menu->commandMetrics.size() == 2);
+	CHECK(menu->GetCommandMaxLatency(a) >= menu->GetCommandLatency(a, 0.5));
+	CHECK(menu->GetCommandLatency(a, 0.99) <= menu->GetCommandMaxLatency(a));
+	std::string text = menu->GetMetricsText();
+	CHECK(text.find("\n" + std::to_string(a) + "\t100\t") != std::string::npos);
+	CHECK(text.find("\tB\n") != std::string::npos);
+
+	menu->ResetMetrics();
+	CHECK(menu->GetCommandCount(a) == 0);
+	CHECK(menu->GetMetricsText().empty());
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,107 @@
+//
+// Items found by name with the name index
+//
+#include "test.h"
+
+class ofApp {};
+
+int main()
+{
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup[3];
+	for(int p = 0; p < 3; p++)
+		hPopup[p] = menu->AddPopupMenu(hMenu, "Popup " + std::to_string(p));
+	menu->SetWindowMenu();
+
+	// Items of several popup menus
+	const int nItems = 2000;
+	std::vector<int> items;
+	for(int i = 0; i < nItems; i++) {
+		if(i % 10 == 9)
+			menu->AddPopupSeparator(hPopup[i % 3]);
+		items.push_back(menu->AddPopupItemID(hPopup[i % 3], "Item " + std::to_string(i)));
+	}
+	for(int i = 0; i < nItems; i += 97)
+		CHECK(menu->FindItem("Item " + std::to_string(i)) == items[i]);
+	CHECK(menu->FindItem("Item") == -1);
+	CHECK(menu->FindItem("") == -1);
+
+	// The name sets the entry at the position of the item
+	for(int i = 0; i < nItems; i += 101) {
+		std::string name = "Item " + std::to_string(i);
+		HMENU hSub = hPopup[i % 3];
+		CHECK(menu->SetPopupItem(name, true));
+		CHECK(menu->GetPopupItem(name));
+		const ofxWinMenuRecorder::entry *e = recorder.GetEntry(hSub, menu->GetItemPosition(items[i]), MF_BYPOSITION);
+		CHECK(e && e->id == (UINT_PTR)items[i] && e->bChecked);
+		CHECK(menu->EnablePopupItem(name, false));
+		CHECK(!recorder.GetEntry(hSub, items[i], MF_BYCOMMAND)->bEnabled);
+	}
+	CHECK(!menu->SetPopupItem("Not an item", true));
+	CHECK(!menu->EnablePopupItem("Not an item", true));
+	CHECK(!menu->GetPopupItem("Not an item"));
+
+	// Positions move when items are inserted before
+	int first = menu->InsertPopupItemAt(hPopup[0], 0, "First");
+	CHECK(menu->GetItemPosition(first) == 0);
+	CHECK(menu->SetPopupItem("Item 0", false));
+	CHECK(menu->SetPopupItem("Item 0", true));
+	CHECK(recorder.GetEntry(hPopup[0], 1, MF_BYPOSITION)->id == (UINT_PTR)items[0]);
+	CHECK(recorder.GetEntry(hPopup[0], 1, MF_BYPOSITION)->bChecked);
+
+	// A removed item is not found and its number is used again
+	CHECK(menu->RemovePopupItem("Item 3"));
+	CHECK(menu->FindItem("Item 3") == -1);
+	CHECK(!menu->SetPopupItem("Item 3", true));
+	int renamed = menu->AddPopupItemID(hPopup[1], "Renamed");
+	CHECK(renamed == items[3]);
+	CHECK(menu->FindItem("Renamed") == renamed);
+
+	// The first item of a name is found, then the next when it is removed
+	int a = menu->AddPopupItemID(hPopup[2], "Same");
+	int b = menu->AddPopupItemID(hPopup[1], "Same");
+	CHECK(a >= 0 && b >= 0 && a != b);
+	CHECK(menu->FindItem("Same") == a);
+	CHECK(menu->RemovePopupItem(a));
+	CHECK(menu->FindItem("Same") == b);
+	CHECK(menu->SetPopupItem("Same", true));
+	CHECK(recorder.GetEntry(hPopup[1], b, MF_BYCOMMAND)->bChecked);
+
+	// A different menu created after the menu is destroyed finds its own items
+	HMENU hContext = menu->CreateContextMenu();
+	CHECK(menu->AddContextItem(hContext, "Item 1"));
+	menu->RemoveWindowMenu();
+	CHECK(menu->DestroyWindowMenu());
+	CHECK(menu->FindItem("Item 1") == -1);
+	CHECK(!menu->SetPopupItem("Item 1", true));
+	CHECK(recorder.GetItemCount(hContext) == 0);
+	hMenu = menu->CreateWindowMenu();
+	HMENU hView = menu->AddPopupMenu(hMenu, "View");
+	int info = menu->AddPopupItemID(hView, "Show info");
+	menu->SetWindowMenu();
+	CHECK(menu->FindItem("Show info") == info);
+	CHECK(menu->SetPopupItem("Show info", true));
+	CHECK(recorder.GetEntry(hView, info, MF_BYCOMMAND)->bChecked);
+	CHECK(menu->GetPopupCount(hMenu) == 1);
+
+	// A menu definition can be used again after the menu is destroyed
+	static const ofxWinMenuDef def[] = {
+		{ OFXMENU_POPUP, "File" },
+			{ OFXMENU_ITEM, "Exit", false, false },
+		{ OFXMENU_END },
+	};
+	menu->RemoveWindowMenu();
+	CHECK(menu->DestroyWindowMenu());
+	CHECK(menu->CreateMenuFromDef(def));
+	CHECK(menu->FindItem("Exit") == 0);
+	CHECK(menu->FindItem("Show info") == -1);
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
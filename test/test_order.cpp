@@ -0,0 +1,108 @@
+//
+// Items inserted and removed at random positions against a reference model
+//
+#include "test.h"
+#include <random>
+
+class ofApp {};
+
+int main()
+{
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup[3];
+	hPopup[0] = menu->AddPopupMenu(hMenu, "A");
+	hPopup[1] = menu->AddPopupMenu(hMenu, "B");
+	hPopup[2] = menu->AddPopupMenu(hPopup[0], "Sub");
+
+	// Reference model of the entries of each popup menu, -1 for a popup menu
+	std::vector<std::vector<int>> model(3);
+	model[0].push_back(-1);
+
+	// Entries of a popup menu and item positions match the model
+	auto Matches = [&](int p) {
+		const std::vector<int> &entries = model[p];
+		if(recorder.GetItemCount(hPopup[p]) != (int)entries.size())
+			return false;
+		for(int i = 0; i < (int)entries.size(); i++) {
+			if(entries[i] < 0)
+				continue;
+			const ofxWinMenuRecorder::entry *e = recorder.GetEntry(hPopup[p], i, MF_BYPOSITION);
+			if(!e || e->id != (UINT_PTR)entries[i] || menu->GetItemPosition(entries[i]) != i)
+				return false;
+		}
+		return true;
+	};
+
+	std::mt19937 random(1);
+	int nFailed = 0;
+	int nWrong = 0;
+	int nLive = 0;
+	int maxLive = 0;
+	int maxItem = -1;
+	for(int step = 0; step < 20000; step++) {
+		int p = random() % 3;
+		std::vector<int> &entries = model[p];
+		if(entries.size() < 5 || random() % 2) {
+			// Insert an item at a random position or at the end,
+			// or add a separator at the end
+			int position = (random() % 4 == 0) ? -1 : (int)(random() % (entries.size() + 1));
+			int item = -1;
+			if(random() % 5 == 0) {
+				position = -1;
+				if(menu->AddPopupSeparator(hPopup[p]))
+					item = (int)recorder.GetEntry(hPopup[p], (UINT)entries.size(), MF_BYPOSITION)->id;
+			}
+			else {
+				item = menu->InsertPopupItemAt(hPopup[p], position, "Item " + std::to_string(step));
+			}
+			if(item < 0) {
+				nFailed++;
+				continue;
+			}
+			if(position < 0)
+				entries.push_back(item);
+			else
+				entries.insert(entries.begin() + position, item);
+			nLive++;
+			maxLive = std::max(maxLive, nLive);
+			maxItem = std::max(maxItem, item);
+		}
+		else {
+			// Remove a random entry other than a popup menu
+			int i = random() % entries.size();
+			if(entries[i] < 0)
+				continue;
+			if(!menu->RemovePopupItem(entries[i]))
+				nFailed++;
+			entries.erase(entries.begin() + i);
+			nLive--;
+		}
+		nWrong += !Matches(p);
+	}
+	CHECK(nFailed == 0);
+	CHECK(nWrong == 0);
+	for(int p = 0; p < 3; p++)
+		CHECK(Matches(p));
+
+	// Item numbers of removed items are used again
+	CHECK(maxItem < maxLive + 3);
+
+	// Removed items are not found by name
+	for(int p = 0; p < 3; p++) {
+		for(int item : model[p]) {
+			if(item >= 0)
+				menu->RemovePopupItem(item);
+		}
+		CHECK(recorder.GetItemCount(hPopup[p]) == (p == 0 ? 1 : 0));
+	}
+	CHECK(menu->FindItem("Item 0") == -1);
+	CHECK(!menu->RemovePopupItem(0));
+
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
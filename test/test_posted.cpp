@@ -0,0 +1,118 @@
+//
+// Item changes posted by many threads are made by the window thread
+//
+#include "test.h"
+
+class ofApp {};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+int main()
+{
+	const int nThreads = 8;
+	const int nItems = 512;
+	const int nPosts = 20000; // For each thread
+
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	std::vector<int> items;
+	for(int i = 0; i < nItems; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i)));
+	menu->SetWindowMenu();
+
+	// Each thread changes its own items, by number and by name
+	std::vector<std::thread> threads;
+	std::atomic<int> nRunning(nThreads);
+	std::vector<char> lastChecked(nItems, false), lastEnabled(nItems, true);
+	for(int t = 0; t < nThreads; t++) {
+		threads.emplace_back([&, t]() {
+			uint32_t random = 12345 + t;
+			for(int n = 0; n < nPosts; n++) {
+				random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+				int i = t + nThreads * (int)(random % (nItems / nThreads));
+				bool bState = (random >> 8) & 1;
+				if(random & 0x10000) {
+					if(n % 4 == 0)
+						menu->PostEnablePopupItem("Item " + std::to_string(i), bState);
+					else
+						menu->PostEnablePopupItem(items[i], bState);
+					lastEnabled[i] = bState;
+				}
+				else {
+					if(n % 4 == 0)
+						menu->PostSetPopupItem("Item " + std::to_string(i), bState);
+					else
+						menu->PostSetPopupItem(items[i], bState);
+					lastChecked[i] = bState;
+				}
+			}
+			nRunning--;
+		});
+	}
+
+	// A thread reading the flags while they change
+	std::atomic<bool> bReading(true);
+	std::atomic<int> nBadSnapshots(0);
+	std::thread reader([&]() {
+		std::vector<uint64_t> checked, enabled;
+		while(bReading) {
+			if(menu->Snapshot(checked, enabled) != nItems)
+				nBadSnapshots++;
+		}
+	});
+
+	// The window thread makes the changes as they arrive
+	int nChanges = 0;
+	while(nRunning > 0)
+		nChanges += menu->ProcessPosted();
+	for(std::thread &thread : threads)
+		thread.join();
+	nChanges += menu->ProcessPosted();
+	bReading = false;
+	reader.join();
+
+	CHECK(nChanges == nThreads * nPosts);
+	CHECK(menu->ProcessPosted() == 0);
+
+	// Messages posted for changes already made make no changes
+	int nRecorded = (int)recorder.GetCalls();
+	HeadlessDispatchPosted();
+	CHECK((int)recorder.GetCalls() == nRecorded);
+	CHECK(nBadSnapshots == 0);
+
+	// The last change of each item is shown
+	int nWrong = 0;
+	for(int i = 0; i < nItems; i++) {
+		const ofxWinMenuRecorder::entry *e = recorder.GetEntry(hPopup, i, MF_BYPOSITION);
+		if(menu->GetPopupItem(items[i]) != lastChecked[i] || e->bChecked != lastChecked[i])
+			nWrong++;
+		if(e->bEnabled != lastEnabled[i])
+			nWrong++;
+	}
+	CHECK(nWrong == 0);
+
+	// The first change posts one message to the window, which makes the changes
+	menu->PostSetPopupItem(items[1], true);
+	menu->PostSetPopupItem(items[2], true);
+	CHECK(HeadlessDispatchPosted() == 1);
+	CHECK(recorder.GetEntry(hPopup, 1, MF_BYPOSITION)->bChecked);
+	CHECK(recorder.GetEntry(hPopup, 2, MF_BYPOSITION)->bChecked);
+	CHECK(menu->ProcessPosted() == 0);
+
+	// Changes are made in the order posted
+	for(int n = 0; n < 1000; n++)
+		menu->PostSetPopupItem(items[0], n % 2 == 0);
+	CHECK(menu->ProcessPosted() == 1000);
+	CHECK(!menu->GetPopupItem(items[0]));
+	CHECK(!recorder.GetEntry(hPopup, 0, MF_BYPOSITION)->bChecked);
+
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,83 @@
+//
+// SaveAsync leaves the file with the states of the last copy taken
+//
+#include "test.h"
+
+class ofApp {};
+
+int main()
+{
+	const int nItems = 2000;
+	const int nSaves = 40;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(nullptr);
+	ofxWinMenu *menu = new ofxWinMenu(nullptr, hwnd, &recorder);
+	HMENU hMenu = menu->CreateWindowMenu();
+	HMENU hPopup = menu->AddPopupMenu(hMenu, "Popup");
+	std::vector<int> items;
+	for(int i = 0; i < nItems; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i)));
+	menu->SetBinaryState(true);
+
+	std::string inipath = "./test_save_async.ini";
+	std::string binpath = menu->GetBinaryPath(inipath);
+
+	for(int round = 0; round < 5; round++) {
+		// Each copy has one more item checked
+		std::vector<std::future<bool>> futures;
+		std::atomic<int> nCalls(0);
+		for(int n = 0; n < nSaves; n++) {
+			for(int i = 0; i < nItems; i++)
+				menu->SetPopupItem(items[i], i <= n);
+			futures.push_back(menu->SaveAsync(inipath, true, [&nCalls](bool) { nCalls++; }));
+		}
+		bool bAllSaved = true;
+		for(std::future<bool> &future : futures)
+			bAllSaved = future.get() && bAllSaved;
+		CHECK(bAllSaved);
+		CHECK(nCalls == nSaves);
+
+		// The file has the last states
+		std::unordered_map<std::string, std::string> keys;
+		CHECK(ofxWinMenu::ReadIniSection(inipath, "Menu", keys));
+		int nChecked = 0;
+		for(auto &key : keys)
+			nChecked += key.second == "1";
+		CHECK(nChecked == nSaves);
+
+		for(int i = 0; i < nItems; i++)
+			menu->SetPopupItem(items[i], false);
+		CHECK(menu->LoadBinary(binpath));
+		int nWrong = 0;
+		for(int i = 0; i < nItems; i++)
+			nWrong += menu->GetPopupItem(items[i]) != (i < nSaves);
+		CHECK(nWrong == 0);
+	}
+
+	// Save after SaveAsync is not replaced by the earlier copy
+	menu->SetPopupItem(items[0], false);
+	std::future<bool> future = menu->SaveAsync(inipath, true);
+	menu->SetPopupItem(items[0], true);
+	menu->SetPopupItem(items[1], false);
+	menu->Save(inipath, true);
+	CHECK(future.get());
+	std::unordered_map<std::string, std::string> keys;
+	ofxWinMenu::ReadIniSection(inipath, "Menu", keys);
+	CHECK(keys["item 0"] == "1" && keys["item 1"] == "0");
+
+	// Deleting the menu waits for writes not yet finished
+	menu->SetPopupItem(items[1], true);
+	menu->SetPopupItem(items[2], false);
+	std::atomic<bool> bCalled(false);
+	menu->SaveAsync(inipath, true, [&bCalled](bool) { bCalled = true; });
+	delete menu;
+	CHECK(bCalled);
+	keys.clear();
+	ofxWinMenu::ReadIniSection(inipath, "Menu", keys);
+	CHECK(keys["item 1"] == "1" && keys["item 2"] == "0");
+
+	DeleteFileA(inipath.c_str());
+	DeleteFileA(binpath.c_str());
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,91 @@
+//
+// Trace of menu activity recorded by the window thread and other threads
+//
+#include "test.h"
+
+class ofApp {
+	public:
+		void appMenuCommand(int, bool) {}
+};
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+int main()
+{
+	ofApp app;
+	ofxWinMenuRecorder recorder;
+	HWND hwnd = HeadlessCreateWindow(AppWndProc);
+	ofxWinMenu *menu = new ofxWinMenu(&app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hPopup = menu->AddPopupMenu(menu->CreateWindowMenu(), "Popup");
+	int item = menu->AddPopupItemID(hPopup, "Show \"info\"");
+	menu->SetWindowMenu();
+
+	// Nothing is recorded before the trace starts
+	SendMessageA(hwnd, WM_COMMAND, item, 0);
+	CHECK(menu->StartTrace(1000));
+	std::vector<ofxWinMenuTrace::event> events;
+	menu->trace->GetEvents(events);
+	CHECK(events.empty());
+
+	// Commands with item functions and marks, with times from the start of the trace
+	for(int n = 0; n < 10; n++) {
+		SendMessageA(hwnd, WM_COMMAND, item, 0);
+		menu->TraceMark("Frame");
+	}
+	menu->trace->GetEvents(events);
+	CHECK(events.size() == 30);
+	int nWrong = 0;
+	for(size_t i = 0; i < events.size(); i++) {
+		nWrong += events[i].start < 0 || events[i].duration < 0;
+		nWrong += i > 0 && events[i].start < events[i - 1].start;
+	}
+	CHECK(nWrong == 0);
+	std::string json = menu->GetTraceJSON();
+	CHECK(json.find("\"name\":\"Command Show \\\"info\\\"\"") != std::string::npos);
+	CHECK(json.find("\"name\":\"Frame\"") != std::string::npos);
+
+	// Other threads record while the trace is started again
+	std::atomic<bool> bStop(false);
+	std::atomic<int> nNegative(0);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; t++) {
+		threads.emplace_back([&]() {
+			while(!bStop) {
+				ofxWinMenuTrace::span span(menu->trace.get(), "Save");
+				if(menu->trace->Now() < -1000000000LL)
+					nNegative++;
+			}
+		});
+	}
+	for(int n = 0; n < 200; n++) {
+		menu->StartTrace(100);
+		SendMessageA(hwnd, WM_COMMAND, item, 0);
+	}
+	// Until the buffer is full
+	for(int n = 0; n < 1000 && menu->trace->GetDropped() == 0; n++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	bStop = true;
+	for(auto &thread : threads)
+		thread.join();
+	CHECK(nNegative == 0);
+	menu->trace->GetEvents(events);
+	CHECK(events.size() == 100);
+	CHECK(menu->trace->GetDropped() > 0);
+
+	// Stopped traces keep their events
+	menu->StopTrace();
+	SendMessageA(hwnd, WM_COMMAND, item, 0);
+	std::vector<ofxWinMenuTrace::event> after;
+	menu->trace->GetEvents(after);
+	CHECK(after.size() == events.size());
+
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+	HeadlessDestroyWindow(hwnd);
+	return TestResult();
+}
@@ -0,0 +1,170 @@
+//
+// Menu objects for several windows and other window procedures in the chain
+//
+#include "test.h"
+#include <CommCtrl.h>
+
+class ofApp {
+	public:
+		void appMenuCommand(int item, bool) {
+			nCommands++;
+			itemSum += item;
+		}
+		int nCommands = 0;
+		long long itemSum = 0;
+};
+
+// Messages received by the application window procedure
+static int nAppMessages = 0;
+
+static LRESULT CALLBACK AppWndProc(HWND, UINT, WPARAM, LPARAM)
+{
+	nAppMessages++;
+	return 0;
+}
+
+// Another subclass of the window, such as a control library
+static int nOtherMessages = 0;
+
+static LRESULT CALLBACK OtherSubclassProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, UINT_PTR, DWORD_PTR)
+{
+	nOtherMessages++;
+	return DefSubclassProc(hwnd, msg, wParam, lParam);
+}
+
+// Another procedure set with SetWindowLongPtr
+static int nRawMessages = 0;
+static WNDPROC rawPrevious = nullptr;
+
+static LRESULT CALLBACK RawWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	nRawMessages++;
+	return CallWindowProc(rawPrevious, hwnd, msg, wParam, lParam);
+}
+
+static ofxWinMenu *CreateMenu(ofApp *app, ofxWinMenuRecorder &recorder, HWND hwnd, std::vector<int> &items)
+{
+	ofxWinMenu *menu = new ofxWinMenu(app, hwnd, &recorder);
+	menu->CreateMenuFunction(&ofApp::appMenuCommand);
+	HMENU hPopup = menu->AddPopupMenu(menu->CreateWindowMenu(), "Popup");
+	items.clear();
+	for(int i = 0; i < 8; i++)
+		items.push_back(menu->AddPopupItemID(hPopup, "Item " + std::to_string(i), false, false));
+	menu->SetWindowMenu();
+	return menu;
+}
+
+static void DeleteMenu(ofxWinMenu *menu)
+{
+	menu->RemoveWindowMenu();
+	menu->DestroyWindowMenu();
+	delete menu;
+}
+
+int main()
+{
+	ofxWinMenuRecorder recorder;
+
+	// Each of 16 windows has its own menu object and application
+	const int nWindows = 16;
+	const int nRounds = 20000;
+	std::vector<HWND> windows;
+	std::vector<ofApp> apps(nWindows);
+	std::vector<ofxWinMenu *> menus;
+	std::vector<int> items;
+	for(int w = 0; w < nWindows; w++) {
+		windows.push_back(HeadlessCreateWindow(AppWndProc));
+		menus.push_back(CreateMenu(&apps[w], recorder, windows.back(), items));
+	}
+
+	// A second menu object for a window is refused
+	ofApp other;
+	ofxWinMenu *second = new ofxWinMenu(&other, windows[0], &recorder);
+	CHECK(!second->bSubclassed);
+	delete second;
+
+	auto start = std::chrono::steady_clock::now();
+	for(int n = 0; n < nRounds; n++) {
+		for(int w = 0; w < nWindows; w++)
+			SendMessageA(windows[w], WM_COMMAND, items[(n + w) % 8], 0);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%d selections for %d windows %.2f ms\n", nRounds * nWindows, nWindows, ms);
+
+	int nWrong = 0;
+	for(int w = 0; w < nWindows; w++) {
+		long long itemSum = 0;
+		for(int n = 0; n < nRounds; n++)
+			itemSum += items[(n + w) % 8];
+		nWrong += apps[w].nCommands != nRounds || apps[w].itemSum != itemSum;
+	}
+	CHECK(nWrong == 0);
+	CHECK(other.nCommands == 0);
+
+	// Messages not handled reach the application procedure
+	nAppMessages = 0;
+	SendMessageA(windows[3], WM_KEYDOWN, 'A', 0);
+	CHECK(nAppMessages == 1);
+
+	// Closing the main window ends the application, closing another window does not
+	nAppMessages = 0;
+	SendMessageA(windows[1], WM_CLOSE, 0, 0);
+	CHECK(HeadlessGetQuitCode() == -1);
+	CHECK(nAppMessages == 1);
+	SendMessageA(windows[0], WM_CLOSE, 0, 0);
+	CHECK(HeadlessGetQuitCode() == 0);
+	CHECK(nAppMessages == 1);
+	CHECK(menus[0]->bQuitOnClose && !menus[1]->bQuitOnClose);
+
+	// Deleting a menu object does not affect the other windows
+	DeleteMenu(menus[5]);
+	menus[5] = nullptr;
+	SendMessageA(windows[5], WM_COMMAND, items[0], 0);
+	SendMessageA(windows[6], WM_COMMAND, items[0], 0);
+	CHECK(apps[5].nCommands == nRounds);
+	CHECK(apps[6].nCommands == nRounds + 1);
+
+	// A menu object can be created again for the window
+	menus[5] = CreateMenu(&apps[5], recorder, windows[5], items);
+	CHECK(menus[5]->bSubclassed);
+	SendMessageA(windows[5], WM_COMMAND, items[0], 0);
+	CHECK(apps[5].nCommands == nRounds + 1);
+
+	// Another subclass set after the menu stays in the chain when the menu is deleted
+	HWND hwnd = windows[7];
+	CHECK(SetWindowSubclass(hwnd, OtherSubclassProc, 7, 0));
+	nAppMessages = nOtherMessages = 0;
+	SendMessageA(hwnd, WM_COMMAND, items[1], 0);
+	CHECK(nOtherMessages == 1 && apps[7].nCommands == nRounds + 1);
+	DeleteMenu(menus[7]);
+	menus[7] = nullptr;
+	SendMessageA(hwnd, WM_COMMAND, items[1], 0);
+	SendMessageA(hwnd, WM_KEYDOWN, 'A', 0);
+	CHECK(nOtherMessages == 3);
+	CHECK(nAppMessages == 3);
+	CHECK(apps[7].nCommands == nRounds + 1);
+	RemoveWindowSubclass(hwnd, OtherSubclassProc, 7);
+
+	// A procedure set with SetWindowLongPtr after the menu also stays in the chain
+	hwnd = windows[8];
+	rawPrevious = (WNDPROC)SetWindowLongPtr(hwnd, GWLP_WNDPROC, (LONG_PTR)RawWndProc);
+	nAppMessages = nRawMessages = 0;
+	SendMessageA(hwnd, WM_COMMAND, items[2], 0);
+	CHECK(nRawMessages == 1 && apps[8].nCommands == nRounds + 1);
+	DeleteMenu(menus[8]);
+	menus[8] = nullptr;
+	SendMessageA(hwnd, WM_COMMAND, items[2], 0);
+	CHECK(nRawMessages == 2 && nAppMessages == 2);
+	CHECK(apps[8].nCommands == nRounds + 1);
+
+	// A destroyed window removes the menu procedure
+	HeadlessDestroyWindow(windows[9]);
+	CHECK(!menus[9]->bSubclassed);
+
+	for(int w = 0; w < nWindows; w++) {
+		if(menus[w])
+			DeleteMenu(menus[w]);
+		HeadlessDestroyWindow(windows[w]);
+	}
+	return TestResult();
+}